@@ -0,0 +1,170 @@
+#include "../src/core.h"
+#include "../src/stream.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_PATH  "/tmp/mylib_file_bench.bin"
+#define COPY_PATH   "/tmp/mylib_file_bench_copy.bin"
+#define FILE_SIZE   MB(256)
+#define NUM_REPS    5
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+// Touches every byte, so the mapped version pays for its page faults too
+internal u64 checksum(const char *data, usize size) {
+    u64 sum = 0;
+    for (usize i = 0; i < size; i += sizeof(u64)) {
+        u64 x;
+        memcpy(&x, data + i, sizeof(x));
+        sum += x;
+    }
+
+    return sum;
+}
+
+// Resident memory not backed by a file, the mapped pages live in the shared page cache instead
+internal usize private_kb(void) {
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == NULL) {
+        return 0;
+    }
+
+    unsigned long pages = 0, resident = 0, shared = 0;
+    if (fscanf(file, "%lu %lu %lu", &pages, &resident, &shared) != 3) {
+        resident = shared = 0;
+    }
+    fclose(file);
+
+    return (resident - shared) * (usize)sysconf(_SC_PAGESIZE) / 1024;
+}
+
+int main(void) {
+    FILE *file = fopen(BENCH_PATH, "wb");
+    assert(file != NULL);
+
+    char *block = (char *)malloc(MB(1));
+    for (usize i = 0; i < MB(1); ++i) {
+        block[i] = (char)(i * 7);
+    }
+    for (usize i = 0; i < FILE_SIZE / MB(1); ++i) {
+        fwrite(block, 1, MB(1), file);
+    }
+    fclose(file);
+    free(block);
+
+    Arena arena;
+    arena_init_virtual(&arena, GB(1));
+
+    f64 best_read = 1e30, best_map = 1e30, best_stream[2] = {1e30, 1e30};
+    u64 sum_read = 0, sum_map = 0, sum_stream[2] = {0, 0};
+    usize rss_read = 0, rss_map = 0, rss_stream[2] = {0, 0};
+
+    // All run from a warm page cache, so this is the cost of the copies and the mapping
+    for (int rep = 0; rep < NUM_REPS; ++rep) {
+        usize base = private_kb();
+        Tmp_Arena tmp = tmp_arena_begin(&arena);
+
+        f64 start = now();
+        i64 size = 0;
+        char *data = file_read(BENCH_PATH, &size, &arena);
+        sum_read = checksum(data, (usize)size);
+        f64 t = now() - start;
+
+        best_read = t < best_read ? t : best_read;
+        rss_read = private_kb() - base;
+
+        tmp_arena_end(tmp);
+
+        base = private_kb();
+        start = now();
+        File_Map map = file_map(BENCH_PATH, FILE_MAP_SEQUENTIAL);
+        sum_map = checksum(map.data, (usize)map.size);
+        t = now() - start;
+
+        best_map = t < best_map ? t : best_map;
+        rss_map = private_kb() - base;
+
+        file_unmap(map);
+
+        for (int read_ahead = 0; read_ahead < 2; ++read_ahead) {
+            base = private_kb();
+            tmp = tmp_arena_begin(&arena);
+            start = now();
+
+            File_Stream stream;
+            file_stream_open(&stream, BENCH_PATH, FILE_STREAM_DEFAULT_CHUNK_SIZE, read_ahead, &arena);
+
+            File_Chunk chunk;
+            sum_stream[read_ahead] = 0;
+            while (file_stream_next_chunk(&stream, &chunk)) {
+                sum_stream[read_ahead] += checksum(chunk.data, chunk.count);
+            }
+
+            file_stream_close(&stream);
+            t = now() - start;
+
+            best_stream[read_ahead] = t < best_stream[read_ahead] ? t : best_stream[read_ahead];
+            rss_stream[read_ahead] = private_kb() - base;
+
+            tmp_arena_end(tmp);
+        }
+    }
+
+    assert(sum_read == sum_map && sum_read == sum_stream[0] && sum_read == sum_stream[1]);
+
+    puts("-- file read vs map vs stream, 256 MB from the page cache (ms, best of 5) --");
+    printf("%-10s %10s %14s\n", "", "time", "private MB");
+    printf("%-10s %10.2f %14zu\n", "file_read", best_read * 1e3, rss_read / 1024);
+    printf("%-10s %10.2f %14zu\n", "file_map", best_map * 1e3, rss_map / 1024);
+    printf("%-10s %10.2f %14zu\n", "stream", best_stream[0] * 1e3, rss_stream[0] / 1024);
+    printf("%-10s %10.2f %14zu\n", "stream+ra", best_stream[1] * 1e3, rss_stream[1] / 1024);
+
+    // Copying: the whole file through an arena buffer against the kernel doing it
+    f64 best_buffered = 1e30, best_copy = 1e30;
+    usize rss_buffered = 0, rss_copy = 0;
+
+    for (int rep = 0; rep < NUM_REPS; ++rep) {
+        usize base = private_kb();
+        Tmp_Arena tmp = tmp_arena_begin(&arena);
+
+        f64 start = now();
+        i64 size = 0;
+        char *data = file_read(BENCH_PATH, &size, &arena);
+        bool ok = file_write(COPY_PATH, data, (usize)size);
+        f64 t = now() - start;
+
+        assert(ok);
+        best_buffered = t < best_buffered ? t : best_buffered;
+        rss_buffered = private_kb() - base;
+
+        tmp_arena_end(tmp);
+        remove(COPY_PATH);
+
+        base = private_kb();
+        start = now();
+        ok = file_copy(BENCH_PATH, COPY_PATH, &arena);
+        t = now() - start;
+
+        assert(ok && file_size(COPY_PATH) == FILE_SIZE);
+        best_copy = t < best_copy ? t : best_copy;
+        rss_copy = private_kb() - base;
+
+        remove(COPY_PATH);
+    }
+
+    puts("-- file copy, 256 MB (ms, best of 5) --");
+    printf("%-10s %10s %14s\n", "", "time", "private MB");
+    printf("%-10s %10.2f %14zu\n", "read+write", best_buffered * 1e3, rss_buffered / 1024);
+    printf("%-10s %10.2f %14zu\n", "file_copy", best_copy * 1e3, rss_copy / 1024);
+
+    remove(BENCH_PATH);
+    arena_release(&arena);
+
+    return 0;
+}
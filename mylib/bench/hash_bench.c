@@ -0,0 +1,136 @@
+#include "../src/core.h"
+#include "../src/hash.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define DATA_SIZE  MB(64)
+#define NUM_KEYS   (1 << 12)
+#define NUM_REPS   (1 << 14)
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+// The usual byte-at-a-time baseline
+internal u64 fnv1a(const void *data, usize size) {
+    const ubyte *p = (const ubyte *)data;
+    u64 h = 0xcbf29ce484222325ull;
+
+    for (usize i = 0; i < size; ++i) {
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    }
+
+    return h;
+}
+
+global u64 keys[NUM_KEYS], hashes[NUM_KEYS];
+global const void *string_keys[NUM_KEYS];
+global usize string_sizes[NUM_KEYS];
+
+int main(void) {
+    // Twice the size so that any offset below DATA_SIZE leaves room for the largest input
+    ubyte *data = (ubyte *)malloc(2 * DATA_SIZE);
+    for (usize i = 0; i < 2 * DATA_SIZE; ++i) {
+        data[i] = (ubyte)(i * 2654435761u >> 13);
+    }
+
+    puts("-- hash benchmark (GB/s) --");
+    printf("%9s %10s %10s %10s\n", "size", "fnv1a", "one-shot", "streaming");
+
+    usize sizes[] = {8, 16, 32, 64, 256, KB(4), KB(64), MB(1), MB(64)};
+    for (usize s = 0; s < countof(sizes); ++s) {
+        usize size = sizes[s];
+        // Hash about 256 MB in total, walking through the buffer so large sizes don't stay in cache
+        usize reps = MB(256) / size;
+        u64 sink = 0;
+
+        f64 start = now();
+        for (usize i = 0; i < reps; ++i) {
+            sink += fnv1a(data + ((i * size) & (DATA_SIZE - 1)), size);
+        }
+        f64 fnv = (f64)(reps * size) / (now() - start) * 1e-9;
+
+        start = now();
+        for (usize i = 0; i < reps; ++i) {
+            sink += hash_bytes(data + ((i * size) & (DATA_SIZE - 1)), size);
+        }
+        f64 one_shot = (f64)(reps * size) / (now() - start) * 1e-9;
+
+        // Fed in pieces of at most 4 KB, like a file read through a fixed buffer
+        start = now();
+        for (usize i = 0; i < reps; ++i) {
+            const ubyte *p = data + ((i * size) & (DATA_SIZE - 1));
+            Hash_State state;
+            hash_begin(&state, 0);
+
+            for (usize off = 0; off < size; off += KB(4)) {
+                hash_update(&state, p + off, size - off < KB(4) ? size - off : KB(4));
+            }
+
+            sink += hash_end(&state);
+        }
+        f64 streaming = (f64)(reps * size) / (now() - start) * 1e-9;
+
+        printf("%9zu %10.2f %10.2f %10.2f%s\n", size, fnv, one_shot, streaming, sink == 42 ? " " : "");
+    }
+
+    for (usize i = 0; i < NUM_KEYS; ++i) {
+        keys[i] = i * 0x9e3779b97f4a7c15ull;
+    }
+
+    // Small enough to stay in L1, so this measures the mixer rather than memory bandwidth
+    puts("\n-- u64 mixer (Mkeys/s) --");
+
+    u64 sink = 0;
+    f64 start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        for (usize i = 0; i < NUM_KEYS; ++i) {
+            hashes[i] = hash_u64_seed(keys[i], rep);
+        }
+        sink += hashes[rep % NUM_KEYS];
+    }
+    f64 scalar = (f64)NUM_REPS * NUM_KEYS / (now() - start) * 1e-6;
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        hash_u64_bulk(keys, hashes, NUM_KEYS, rep);
+        sink += hashes[rep % NUM_KEYS];
+    }
+    f64 bulk = (f64)NUM_REPS * NUM_KEYS / (now() - start) * 1e-6;
+
+    printf("scalar %.0f, bulk %.0f%s\n", scalar, bulk, sink == 42 ? " " : "");
+
+    // Short string keys, as a hash map or interner would see them
+    puts("\n-- 16-byte keys (Mkeys/s) --");
+
+    for (usize i = 0; i < NUM_KEYS; ++i) {
+        string_keys[i] = data + i * 16;
+        string_sizes[i] = 16;
+    }
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        for (usize i = 0; i < NUM_KEYS; ++i) {
+            hashes[i] = hash_bytes_seed(string_keys[i], string_sizes[i], rep);
+        }
+        sink += hashes[rep % NUM_KEYS];
+    }
+    scalar = (f64)NUM_REPS * NUM_KEYS / (now() - start) * 1e-6;
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        hash_bytes_bulk(string_keys, string_sizes, hashes, NUM_KEYS, rep);
+        sink += hashes[rep % NUM_KEYS];
+    }
+    bulk = (f64)NUM_REPS * NUM_KEYS / (now() - start) * 1e-6;
+
+    printf("scalar %.0f, bulk %.0f%s\n", scalar, bulk, sink == 42 ? " " : "");
+
+    free(data);
+
+    return 0;
+}
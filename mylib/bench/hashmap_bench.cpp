@@ -0,0 +1,74 @@
+#include "../src/hashmap.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unordered_map>
+
+#define MAX_N  (1 << 22)
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+global u64 keys[MAX_N], misses[MAX_N];
+
+// Lookups visit the keys out of insertion order, an odd multiplier permutes a power-of-two range
+#define shuffle(i, n) (((i) * 2654435761ull) & ((n) - 1))
+
+// Nanoseconds per operation over 'n' operations
+#define TIME(n, stmt) ([&]() { \
+        f64 start = now(); \
+        stmt; \
+        return (now() - start) * 1e9 / (f64)(n); \
+    }())
+
+int main(void) {
+    u64 x = 88172645463325252ull;
+    for (usize i = 0; i < MAX_N; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        // Even keys are inserted, odd ones are guaranteed misses
+        keys[i] = x & ~1ull;
+        misses[i] = x | 1;
+    }
+
+    puts("-- hash map benchmark (ns/op) --");
+    printf("%-14s %9s %10s %10s %10s %10s\n", "map", "n", "insert", "hit", "miss", "remove");
+
+    for (usize n = 1 << 10; n <= MAX_N; n <<= 3) {
+        u64 sink = 0;
+
+        {
+            Hash_Map<u64, u64> m;
+
+            f64 insert = TIME(n, for (usize i = 0; i < n; ++i) m.put(keys[i], i));
+            f64 hit    = TIME(n, for (usize i = 0; i < n; ++i) sink += *m.get(keys[shuffle(i, n)]));
+            f64 miss   = TIME(n, for (usize i = 0; i < n; ++i) sink += m.get(misses[i]) != NULL);
+            f64 remove = TIME(n, for (usize i = 0; i < n; ++i) sink += m.remove(keys[i]));
+
+            printf("%-14s %9zu %10.1f %10.1f %10.1f %10.1f\n", "Hash_Map", n, insert, hit, miss, remove);
+        }
+
+        {
+            std::unordered_map<u64, u64> m;
+
+            f64 insert = TIME(n, for (usize i = 0; i < n; ++i) m[keys[i]] = i);
+            f64 hit    = TIME(n, for (usize i = 0; i < n; ++i) sink += m.find(keys[shuffle(i, n)])->second);
+            f64 miss   = TIME(n, for (usize i = 0; i < n; ++i) sink += m.find(misses[i]) != m.end());
+            f64 remove = TIME(n, for (usize i = 0; i < n; ++i) sink += m.erase(keys[i]));
+
+            printf("%-14s %9zu %10.1f %10.1f %10.1f %10.1f\n", "unordered_map", n, insert, hit, miss, remove);
+        }
+
+        if (sink == 42) {
+            puts("");
+        }
+    }
+
+    return 0;
+}
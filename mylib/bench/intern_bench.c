@@ -0,0 +1,85 @@
+#include "../src/core.h"
+#include "../src/intern.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define NUM_NAMES   4096
+#define NUM_TOKENS  (1 << 21)
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+global const char *tokens[NUM_TOKENS];
+global u32 ids[NUM_TOKENS];
+
+int main(void) {
+    // A few thousand identifiers sharing a long prefix, which is the worst case for 'strcmp'
+    local char names[NUM_NAMES][48];
+    for (u32 i = 0; i < NUM_NAMES; ++i) {
+        sprintf(names[i], "pipeline.stage.material.parameter_%u", i);
+    }
+
+    // The same identifiers spread through a large file
+    String_Builder sb;
+    Arena arena;
+    arena_init_virtual(&arena, GB(4));
+    string_builder_init(&sb, &arena);
+
+    u32 x = 1;
+    for (u32 i = 0; i < NUM_TOKENS; ++i) {
+        x = x * 1103515245u + 12345u;
+        tokens[i] = names[(x >> 8) % NUM_NAMES];
+        string_builder_append_cstr(&sb, tokens[i]);
+        string_builder_append_byte(&sb, '\n');
+    }
+
+    String text = string_builder_end(&sb);
+
+    Arena intern_arena;
+    arena_init_virtual(&intern_arena, GB(1));
+    Interner interner;
+    interner_init(&interner, &intern_arena);
+
+    puts("-- intern benchmark --");
+
+    f64 start = now();
+    u32 *split = interner_put_split(&interner, text, '\n', arena_allocator(&arena));
+    f64 bulk = (now() - start) * 1e9 / NUM_TOKENS;
+
+    start = now();
+    for (u32 i = 0; i < NUM_TOKENS; ++i) {
+        ids[i] = interner_put_cstr(&interner, tokens[i]);
+    }
+    f64 put = (now() - start) * 1e9 / NUM_TOKENS;
+
+    printf("%.1f MB, %u unique: put_split %.1f ns/token, put %.1f ns/token\n",
+           (f64)text.count / MB(1), interner_count(&interner), bulk, put);
+
+    // Counting the tokens equal to their predecessor
+    usize same = 0;
+
+    start = now();
+    for (u32 i = 1; i < NUM_TOKENS; ++i) {
+        same += strcmp(tokens[i], tokens[i - 1]) == 0;
+    }
+    f64 cmp = (now() - start) * 1e9 / NUM_TOKENS;
+
+    start = now();
+    for (u32 i = 1; i < NUM_TOKENS; ++i) {
+        same += ids[i] == ids[i - 1];
+    }
+    f64 id = (now() - start) * 1e9 / NUM_TOKENS;
+
+    printf("equality: strcmp %.2f ns, ID %.2f ns%s\n", cmp, id, same == 42 || split == NULL ? " " : "");
+
+    interner_release(&interner);
+    arena_release(&intern_arena);
+    arena_release(&arena);
+
+    return 0;
+}
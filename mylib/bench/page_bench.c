@@ -0,0 +1,97 @@
+#include "../src/core.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+
+#define BUFFER_SIZE  GB(1)
+#define NUM_READS    20000000
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+// Returns -1 when the kernel doesn't let us count dTLB misses (e.g. inside containers)
+internal i32 dtlb_counter_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (i32)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+internal void random_reads(Arena *arena, const char *label) {
+    u64 *data = (u64 *)arena_alloc(arena, BUFFER_SIZE);
+    usize count = BUFFER_SIZE / sizeof(u64);
+
+    // Fault everything in before measuring
+    for (usize i = 0; i < count; ++i) {
+        data[i] = i;
+    }
+
+    i32 fd = dtlb_counter_open();
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    u64 x = 0x9e3779b97f4a7c15ull, sum = 0;
+    f64 start = now();
+
+    for (usize i = 0; i < NUM_READS; ++i) {
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        sum += data[(x * 2685821657736338717ull) % count];
+    }
+
+    f64 elapsed = now() - start;
+
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        u64 misses = 0;
+        if (read(fd, &misses, sizeof(misses)) == sizeof(misses)) {
+            printf("%-24s %8.2f ns/read %14llu dTLB misses (checksum %llu)\n",
+                   label, elapsed * 1e9 / NUM_READS, (unsigned long long)misses, (unsigned long long)sum);
+        }
+
+        close(fd);
+    } else {
+        printf("%-24s %8.2f ns/read %14s dTLB misses (checksum %llu)\n",
+               label, elapsed * 1e9 / NUM_READS, "n/a", (unsigned long long)sum);
+    }
+}
+
+int main(void) {
+    puts("-- random reads over 1 GB: regular vs huge pages --");
+
+    void *mem = mmap(NULL, BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(mem != MAP_FAILED);
+
+#ifdef MADV_NOHUGEPAGE
+    madvise(mem, BUFFER_SIZE, MADV_NOHUGEPAGE);
+#endif // MADV_NOHUGEPAGE
+
+    Arena regular;
+    arena_init(&regular, mem, BUFFER_SIZE);
+    random_reads(&regular, "4 KB pages");
+    munmap(mem, BUFFER_SIZE);
+
+    Arena huge;
+    Page_Mem page_mem = arena_init_huge(&huge, BUFFER_SIZE, NUMA_NODE_ANY);
+    assert(page_mem.data != NULL);
+    random_reads(&huge, page_mem.huge_tlb ? "hugetlbfs pages" : "transparent huge pages");
+    page_mem_free(page_mem);
+
+    return 0;
+}
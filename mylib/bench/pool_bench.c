@@ -0,0 +1,122 @@
+#include "../src/core.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+#define MAX_THREADS  16
+#define NUM_CHUNKS   4096
+#define NUM_OPS      2000000
+#define BATCH        8
+#define CHUNK_SIZE   64
+
+global ubyte buffer[NUM_CHUNKS * CHUNK_SIZE + POOL_DEFAULT_ALIGNMENT];
+
+global Pool            locked_pool;
+global pthread_mutex_t locked_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+global Atomic_Pool     atomic_pool;
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+void *locked_worker(void *arg) {
+    usize ops = (usize)arg;
+    void *held[BATCH];
+
+    for (usize i = 0; i < ops; i += BATCH) {
+        for (usize j = 0; j < BATCH; ++j) {
+            pthread_mutex_lock(&locked_pool_mutex);
+            held[j] = pool_alloc(&locked_pool);
+            pthread_mutex_unlock(&locked_pool_mutex);
+        }
+
+        for (usize j = 0; j < BATCH; ++j) {
+            pthread_mutex_lock(&locked_pool_mutex);
+            pool_free(&locked_pool, held[j]);
+            pthread_mutex_unlock(&locked_pool_mutex);
+        }
+    }
+
+    return NULL;
+}
+
+void *atomic_worker(void *arg) {
+    usize ops = (usize)arg;
+    void *held[BATCH];
+
+    for (usize i = 0; i < ops; i += BATCH) {
+        for (usize j = 0; j < BATCH; ++j) {
+            held[j] = atomic_pool_alloc(&atomic_pool);
+        }
+
+        for (usize j = 0; j < BATCH; ++j) {
+            atomic_pool_free(&atomic_pool, held[j]);
+        }
+    }
+
+    return NULL;
+}
+
+void *magazine_worker(void *arg) {
+    usize ops = (usize)arg;
+    void *held[BATCH];
+
+    Pool_Magazine mag;
+    pool_magazine_init(&mag, &atomic_pool);
+
+    for (usize i = 0; i < ops; i += BATCH) {
+        for (usize j = 0; j < BATCH; ++j) {
+            held[j] = pool_magazine_alloc(&mag);
+        }
+
+        for (usize j = 0; j < BATCH; ++j) {
+            pool_magazine_free(&mag, held[j]);
+        }
+    }
+
+    pool_magazine_flush(&mag);
+
+    return NULL;
+}
+
+internal f64 run(void *(*worker)(void *), usize num_threads) {
+    pthread_t threads[MAX_THREADS];
+    usize ops = NUM_OPS / num_threads;
+
+    f64 start = now();
+
+    for (usize i = 0; i < num_threads; ++i) {
+        pthread_create(&threads[i], NULL, worker, (void *)ops);
+    }
+
+    for (usize i = 0; i < num_threads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Millions of alloc/free pairs per second
+    return (f64)(ops * num_threads) / (now() - start) * 1e-6;
+}
+
+int main(void) {
+    puts("-- pool throughput (M alloc/free pairs per second) --");
+    printf("%8s %12s %12s %12s\n", "threads", "mutex", "atomic", "magazine");
+
+    for (usize num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2) {
+        pool_init(&locked_pool, buffer, sizeof(buffer), CHUNK_SIZE);
+        f64 locked = run(locked_worker, num_threads);
+
+        atomic_pool_init(&atomic_pool, buffer, sizeof(buffer), CHUNK_SIZE);
+        f64 atomic = run(atomic_worker, num_threads);
+
+        atomic_pool_init(&atomic_pool, buffer, sizeof(buffer), CHUNK_SIZE);
+        f64 magazine = run(magazine_worker, num_threads);
+
+        printf("%8zu %12.2f %12.2f %12.2f\n", num_threads, locked, atomic, magazine);
+    }
+
+    return 0;
+}
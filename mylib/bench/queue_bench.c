@@ -0,0 +1,150 @@
+#include "../src/core.h"
+#include "../src/queue.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define NUM_ITEMS  (1 << 22)
+#define CAPACITY   1024
+#define BATCH      32
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+// The mutex-guarded ring the lock-free queues replace
+typedef struct _Locked_Queue {
+    pthread_mutex_t lock;
+    u64             items[CAPACITY];
+    usize           head, tail;
+} Locked_Queue;
+
+global Locked_Queue locked;
+global Spsc_Queue spsc;
+global Mpmc_Queue mpmc;
+
+typedef enum _Kind {
+    KIND_LOCKED,
+    KIND_SPSC,
+    KIND_MPMC,
+} Kind;
+
+typedef struct _Job {
+    Kind kind;
+    usize batch;
+} Job;
+
+internal usize push(Kind kind, u64 *items, usize count) {
+    switch (kind) {
+        case KIND_LOCKED: {
+            pthread_mutex_lock(&locked.lock);
+            usize n = 0;
+            for (; n < count && locked.tail - locked.head < CAPACITY; ++n) {
+                locked.items[locked.tail++ % CAPACITY] = items[n];
+            }
+            pthread_mutex_unlock(&locked.lock);
+            return n;
+        }
+        case KIND_SPSC: return spsc_queue_push_batch(&spsc, items, count);
+        case KIND_MPMC: return mpmc_queue_push_batch(&mpmc, items, count);
+    }
+
+    return 0;
+}
+
+internal usize pop(Kind kind, u64 *items, usize count) {
+    switch (kind) {
+        case KIND_LOCKED: {
+            pthread_mutex_lock(&locked.lock);
+            usize n = 0;
+            for (; n < count && locked.head < locked.tail; ++n) {
+                items[n] = locked.items[locked.head++ % CAPACITY];
+            }
+            pthread_mutex_unlock(&locked.lock);
+            return n;
+        }
+        case KIND_SPSC: return spsc_queue_pop_batch(&spsc, items, count);
+        case KIND_MPMC: return mpmc_queue_pop_batch(&mpmc, items, count);
+    }
+
+    return 0;
+}
+
+void *producer(void *arg) {
+    Job *job = (Job *)arg;
+    u64 items[BATCH];
+
+    for (usize i = 0; i < NUM_ITEMS; i += job->batch) {
+        for (usize j = 0; j < job->batch; ++j) {
+            items[j] = i + j;
+        }
+
+        for (usize sent = 0; sent < job->batch;) {
+            usize n = push(job->kind, items + sent, job->batch - sent);
+            if (n == 0) {
+                sched_yield();
+            }
+            sent += n;
+        }
+    }
+
+    return NULL;
+}
+
+internal f64 run(Kind kind, usize batch) {
+    Job job = {kind, batch};
+    u64 items[BATCH], sum = 0;
+
+    f64 start = now();
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer, &job);
+
+    for (usize received = 0; received < NUM_ITEMS;) {
+        usize n = pop(kind, items, batch);
+        if (n == 0) {
+            sched_yield();
+        }
+
+        for (usize i = 0; i < n; ++i) {
+            sum += items[i];
+        }
+        received += n;
+    }
+
+    pthread_join(thread, NULL);
+    assert(sum == (u64)NUM_ITEMS * (NUM_ITEMS - 1) / 2);
+
+    return (now() - start) * 1e9 / NUM_ITEMS;
+}
+
+int main(void) {
+    Arena arena;
+    arena_init_virtual(&arena, MB(64));
+
+    pthread_mutex_init(&locked.lock, NULL);
+    spsc_queue_init_arena(&spsc, &arena, CAPACITY, sizeof(u64));
+    mpmc_queue_init_arena(&mpmc, &arena, CAPACITY, sizeof(u64));
+
+    puts("-- queue benchmark, one producer and one consumer (ns/item) --");
+    printf("%-8s %10s %10s %10s\n", "batch", "mutex", "spsc", "mpmc");
+
+    usize batches[] = {1, BATCH};
+    for (usize b = 0; b < countof(batches); ++b) {
+        f64 l = run(KIND_LOCKED, batches[b]);
+        f64 s = run(KIND_SPSC, batches[b]);
+        f64 m = run(KIND_MPMC, batches[b]);
+
+        printf("%-8zu %10.2f %10.2f %10.2f\n", batches[b], l, s, m);
+    }
+
+    pthread_mutex_destroy(&locked.lock);
+    arena_release(&arena);
+
+    return 0;
+}
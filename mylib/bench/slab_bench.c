@@ -0,0 +1,97 @@
+#include "../src/core.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define NUM_LIVE  16384
+#define NUM_OPS   10000000
+#define NUM_SIZES 4096
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+internal u64 rng_state = 0x9e3779b97f4a7c15ull;
+
+// xorshift64*, good enough to pick sizes and slots
+internal u64 rng(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+
+    return rng_state * 2685821657736338717ull;
+}
+
+global void  *live[NUM_LIVE];
+global usize  sizes[NUM_SIZES];
+
+internal f64 run_malloc(void) {
+    f64 start = now();
+
+    for (usize i = 0; i < NUM_OPS; ++i) {
+        usize slot = (usize)(rng() % NUM_LIVE);
+
+        free(live[slot]);
+        live[slot] = malloc(sizes[i % countof(sizes)]);
+        *(ubyte *)live[slot] = (ubyte)i;
+    }
+
+    for (usize i = 0; i < NUM_LIVE; ++i) {
+        free(live[i]);
+        live[i] = NULL;
+    }
+
+    return now() - start;
+}
+
+internal f64 run_slab(Slab *slab) {
+    f64 start = now();
+
+    for (usize i = 0; i < NUM_OPS; ++i) {
+        usize slot = (usize)(rng() % NUM_LIVE);
+
+        slab_free(slab, live[slot]);
+        live[slot] = slab_alloc(slab, sizes[i % countof(sizes)]);
+        *(ubyte *)live[slot] = (ubyte)i;
+    }
+
+    for (usize i = 0; i < NUM_LIVE; ++i) {
+        slab_free(slab, live[i]);
+        live[i] = NULL;
+    }
+
+    return now() - start;
+}
+
+int main(void) {
+    puts("-- slab vs malloc (ns per free + alloc) --");
+    printf("%16s %12s %12s\n", "sizes", "malloc", "slab");
+
+    usize max_sizes[] = {64, 256, 1024, 8192};
+
+    for (usize m = 0; m < countof(max_sizes); ++m) {
+        for (usize i = 0; i < countof(sizes); ++i) {
+            // Skewed towards small objects
+            usize r = (usize)(rng() % max_sizes[m]) + 1;
+            sizes[i] = (rng() & 1) ? r : r / 4 + 1;
+        }
+
+        rng_state = 0x9e3779b97f4a7c15ull;
+        f64 heap = run_malloc();
+
+        Slab slab;
+        slab_init(&slab, GB(4));
+
+        rng_state = 0x9e3779b97f4a7c15ull;
+        f64 slab_time = run_slab(&slab);
+
+        slab_release(&slab);
+
+        printf("%10s%6zu %12.2f %12.2f\n", "1..", max_sizes[m], heap * 1e9 / NUM_OPS, slab_time * 1e9 / NUM_OPS);
+    }
+
+    return 0;
+}
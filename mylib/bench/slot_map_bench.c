@@ -0,0 +1,106 @@
+#include "../src/core.h"
+#include "../src/slot_map.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define NUM_ENTITIES  (1 << 20)
+#define NUM_REPS      16
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+typedef struct _Entity {
+    f32 position[3];
+    f32 velocity[3];
+} Entity;
+
+// The pointer-chasing version: entities from a pool, linked in allocation order
+typedef struct _Entity_Node {
+    Entity               entity;
+    struct _Entity_Node *next;
+} Entity_Node;
+
+global Slot_Handle handles[NUM_ENTITIES];
+
+int main(void) {
+    usize pool_size = NUM_ENTITIES * sizeof(Entity_Node) + POOL_DEFAULT_ALIGNMENT;
+    void *pool_mem = malloc(pool_size);
+    Pool pool;
+    pool_init(&pool, pool_mem, pool_size, sizeof(Entity_Node));
+
+    usize map_size = slot_map_buffer_size(NUM_ENTITIES, sizeof(Entity));
+    void *map_mem = malloc(map_size);
+    Slot_Map map;
+    slot_map_init(&map, map_mem, map_size, sizeof(Entity));
+
+    // Spawn everything, then despawn and respawn a scattered half, like a game some minutes in
+    Entity_Node **nodes = (Entity_Node **)malloc(NUM_ENTITIES * sizeof(Entity_Node *));
+    for (u32 i = 0; i < NUM_ENTITIES; ++i) {
+        nodes[i] = (Entity_Node *)pool_alloc(&pool);
+        slot_map_alloc(&map, &handles[i]);
+    }
+
+    u32 x = 1;
+    for (u32 i = 0; i < NUM_ENTITIES / 2; ++i) {
+        x = x * 1103515245u + 12345u;
+        u32 j = (x >> 4) % NUM_ENTITIES;
+
+        pool_free(&pool, nodes[j]);
+        nodes[j] = (Entity_Node *)pool_alloc(&pool);
+
+        slot_map_remove(&map, handles[j]);
+        slot_map_alloc(&map, &handles[j]);
+    }
+
+    for (u32 i = 0; i < NUM_ENTITIES; ++i) {
+        Entity e = {{(f32)i, 0.0f, 0.0f}, {1.0f, 2.0f, 3.0f}};
+        nodes[i]->entity = e;
+        nodes[i]->next = i + 1 < NUM_ENTITIES ? nodes[i + 1] : NULL;
+        *(Entity *)slot_map_get(&map, handles[i]) = e;
+    }
+
+    puts("-- slot map benchmark (ns/entity) --");
+
+    f64 start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        for (Entity_Node *n = nodes[0]; n != NULL; n = n->next) {
+            for (u32 k = 0; k < 3; ++k) {
+                n->entity.position[k] += n->entity.velocity[k];
+            }
+        }
+    }
+    f64 list = (now() - start) * 1e9 / ((f64)NUM_REPS * NUM_ENTITIES);
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        Entity *all = (Entity *)map.data;
+
+        for (u32 i = 0; i < map.count; ++i) {
+            for (u32 k = 0; k < 3; ++k) {
+                all[i].position[k] += all[i].velocity[k];
+            }
+        }
+    }
+    f64 dense = (now() - start) * 1e9 / ((f64)NUM_REPS * NUM_ENTITIES);
+
+    // Random access through handles costs one extra indirection over a pointer
+    f32 sink = 0.0f;
+    start = now();
+    for (u32 i = 0; i < NUM_ENTITIES; ++i) {
+        sink += ((Entity *)slot_map_get(&map, handles[(i * 2654435761u) & (NUM_ENTITIES - 1)]))->position[0];
+    }
+    f64 lookup = (now() - start) * 1e9 / NUM_ENTITIES;
+
+    printf("update: pool list %.2f, slot map %.2f; handle lookup %.2f%s\n", list, dense, lookup, sink == 42.0f ? " " : "");
+
+    free(nodes);
+    free(map_mem);
+    free(pool_mem);
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "../src/sort.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+
+#define MAX_N  (1 << 22)
+
+#define u32_less(a, b) ((a) < (b))
+SORT_DEFINE(u32, u32, u32_less)
+PARALLEL_SORT_DEFINE(u32, u32, u32_less)
+
+#define f64_less(a, b) ((a) < (b))
+SORT_DEFINE(f64, f64, f64_less)
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+internal int u32_cmp(const void *a, const void *b) {
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+    return (x > y) - (x < y);
+}
+
+internal int f64_cmp(const void *a, const void *b) {
+    f64 x = *(const f64 *)a, y = *(const f64 *)b;
+
+    return (x > y) - (x < y);
+}
+
+typedef enum _Distribution {
+    DISTRIBUTION_RANDOM,
+    DISTRIBUTION_SORTED,
+    DISTRIBUTION_FEW_UNIQUE,
+    DISTRIBUTION_COUNT
+} Distribution;
+
+global const char *distribution_names[DISTRIBUTION_COUNT] = {"random", "sorted", "few unique"};
+
+global u32 src_u32[MAX_N], buf_u32[MAX_N];
+global f64 src_f64[MAX_N], buf_f64[MAX_N];
+
+internal void fill(usize n, Distribution dist) {
+    u64 x = 88172645463325252ull;
+
+    for (usize i = 0; i < n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        switch (dist) {
+            case DISTRIBUTION_RANDOM:     src_u32[i] = (u32)x; src_f64[i] = (f64)(i64)x * 1e-9; break;
+            case DISTRIBUTION_SORTED:     src_u32[i] = (u32)i; src_f64[i] = (f64)i; break;
+            case DISTRIBUTION_FEW_UNIQUE: src_u32[i] = (u32)(x % 16); src_f64[i] = (f64)(x % 16); break;
+            default: break;
+        }
+    }
+}
+
+// Milliseconds for the best of a few runs
+#define TIME(buf, src, n, stmt) ([&]() { \
+        f64 best = 1e30; \
+        for (int rep = 0; rep < 3; ++rep) { \
+            memcpy(buf, src, (n) * sizeof(*(buf))); \
+            f64 start = now(); \
+            stmt; \
+            f64 t = now() - start; \
+            best = t < best ? t : best; \
+        } \
+        return best * 1e3; \
+    }())
+
+int main(void) {
+    puts("-- sort benchmark (ms, best of 3) --");
+    printf("%-5s %-11s %9s %10s %10s %10s %10s\n", "type", "dist", "n", "qsort", "std::sort", "introsort", "radix");
+
+    for (usize n = 1000; n <= MAX_N; n *= 16) {
+        for (int d = 0; d < DISTRIBUTION_COUNT; ++d) {
+            fill(n, (Distribution)d);
+
+            f64 q = TIME(buf_u32, src_u32, n, qsort(buf_u32, n, sizeof(u32), u32_cmp));
+            f64 s = TIME(buf_u32, src_u32, n, std::sort(buf_u32, buf_u32 + n));
+            f64 i = TIME(buf_u32, src_u32, n, u32_sort(buf_u32, n));
+            f64 r = TIME(buf_u32, src_u32, n, u32_radix_sort(buf_u32, n));
+            printf("%-5s %-11s %9zu %10.3f %10.3f %10.3f %10.3f\n", "u32", distribution_names[d], n, q, s, i, r);
+
+            q = TIME(buf_f64, src_f64, n, qsort(buf_f64, n, sizeof(f64), f64_cmp));
+            s = TIME(buf_f64, src_f64, n, std::sort(buf_f64, buf_f64 + n));
+            i = TIME(buf_f64, src_f64, n, sort(buf_f64, n));
+            r = TIME(buf_f64, src_f64, n, f64_radix_sort(buf_f64, n));
+            printf("%-5s %-11s %9zu %10.3f %10.3f %10.3f %10.3f\n", "f64", distribution_names[d], n, q, s, i, r);
+        }
+    }
+
+    puts("-- parallel sort scaling (ms, best of 3) --");
+    printf("%-5s %9s %8s %10s\n", "type", "n", "workers", "time");
+
+    fill(MAX_N, DISTRIBUTION_RANDOM);
+
+    Arena mem;
+    arena_init_virtual(&mem, GB(1));
+
+    for (u32 num_workers = 1; num_workers <= 2 * _job_default_workers(); num_workers *= 2) {
+        Job_System jobs;
+        if (!job_system_init(&jobs, num_workers, &mem)) {
+            break;
+        }
+
+        f64 ms = TIME(buf_u32, src_u32, MAX_N, u32_parallel_sort(buf_u32, MAX_N, &mem, &jobs));
+        printf("%-5s %9d %8u %10.3f\n", "u32", MAX_N, num_workers, ms);
+
+        job_system_release(&jobs);
+    }
+
+    arena_release(&mem);
+    scratch_release();
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "../src/core.h"
+#include "../src/str.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define TEXT_SIZE  MB(16)
+#define NUM_REPS   8
+
+internal f64 now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+// Config-like text: indented 'key = value' lines of varying length
+internal usize make_text(char *text, usize size) {
+    usize n = 0;
+    u32 x = 12345;
+
+    while (n + 128 < size) {
+        x = x * 1103515245u + 12345u;
+
+        n += (usize)sprintf(text + n, "%*skey_%u = value_%.*s\n", (int)(x >> 28), "", x >> 16 & 0xFFF,
+                            (int)(x >> 8 & 63), "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijk");
+    }
+
+    text[n] = '\0';
+
+    return n;
+}
+
+int main(void) {
+    char *text = (char *)malloc(TEXT_SIZE);
+    char *copy = (char *)malloc(TEXT_SIZE);
+    usize size = make_text(text, TEXT_SIZE);
+
+    puts("-- string benchmark (ms per 16 MB) --");
+    usize sink = 0;
+
+    // Splitting into lines and trimming each, the way a config parser walks a file
+    f64 start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        String rest = string_make(text, size), line;
+
+        while (string_split_next(&rest, '\n', &line)) {
+            sink += string_trim(line).count;
+        }
+    }
+    f64 split = (now() - start) * 1e3 / NUM_REPS;
+
+    // 'strtok' writes into the text, so every rep works on a fresh copy, which is timed separately
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        memcpy(copy, text, size + 1);
+    }
+    f64 memcpy_time = (now() - start) * 1e3 / NUM_REPS;
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        memcpy(copy, text, size + 1);
+
+        for (char *line = strtok(copy, "\n"); line; line = strtok(NULL, "\n")) {
+            while (*line == ' ') {
+                ++line;
+            }
+            sink += strlen(line);
+        }
+    }
+    f64 strtok_time = (now() - start) * 1e3 / NUM_REPS - memcpy_time;
+
+    printf("split + trim:   %8.2f   strtok + strlen: %8.2f\n", split, strtok_time);
+
+    // Searching for something that is not there scans the whole text. Each rep starts at a different
+    // offset, otherwise the compiler hoists the pure libc calls out of the loop.
+    String s = string_make(text, size);
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        sink += (usize)string_find_byte(string_slice(s, rep, size), '#');
+    }
+    f64 find_byte = (now() - start) * 1e3 / NUM_REPS;
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        sink += memchr(text + rep, '#', size - rep) != NULL;
+    }
+    f64 memchr_time = (now() - start) * 1e3 / NUM_REPS;
+
+    printf("find_byte:      %8.2f   memchr:          %8.2f\n", find_byte, memchr_time);
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        sink += (usize)string_find(string_slice(s, rep, size), string_lit("key_9999"));
+    }
+    f64 find = (now() - start) * 1e3 / NUM_REPS;
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        sink += strstr(text + rep, "key_9999") != NULL;
+    }
+    f64 strstr_time = (now() - start) * 1e3 / NUM_REPS;
+
+    printf("find:           %8.2f   strstr:          %8.2f\n", find, strstr_time);
+
+    // Building the text back up line by line
+    Arena arena;
+    arena_init_virtual(&arena, GB(1));
+
+    start = now();
+    for (u32 rep = 0; rep < NUM_REPS; ++rep) {
+        arena_clear(&arena);
+
+        String_Builder sb;
+        string_builder_init(&sb, &arena);
+
+        String rest = string_make(text, size), line;
+        while (string_split_next(&rest, '\n', &line)) {
+            string_builder_append(&sb, line);
+            string_builder_append_byte(&sb, '\n');
+        }
+
+        sink += string_builder_end(&sb).count;
+    }
+    f64 build = (now() - start) * 1e3 / NUM_REPS;
+
+    printf("builder:        %8.2f%s\n", build, sink == 42 ? " " : "");
+
+    arena_release(&arena);
+    free(copy);
+    free(text);
+
+    return 0;
+}
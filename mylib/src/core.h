@@ -8,7 +8,13 @@
 #include <stdarg.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 // --------------------------------------------------------------------------------
 
@@ -46,23 +52,293 @@ internal uptr align_forward(uptr ptr, usize alignment) {
 
 // --------------------------------------------------------------------------------
 
+// Define MEM_STATS to have arenas and pools record usage statistics, which is useful to size memory
+// budgets from data. Without it the bookkeeping compiles out completely.
+
+#ifdef MEM_STATS
+#   define mem_stat(x)  x
+#else
+#   define mem_stat(x)
+#endif // MEM_STATS
+
+typedef struct _Arena_Stats {
+    usize peak_offset;
+    usize num_allocs, num_failed;
+    // Bytes skipped over by 'align_forward' padding
+    usize align_waste;
+    // Number of 'tmp_arena_begin' calls still waiting for their 'tmp_arena_end'
+    isize tmp_depth;
+    isize peak_tmp_depth;
+} Arena_Stats;
+
+typedef struct _Pool_Stats {
+    usize num_allocs, num_frees, num_failed;
+    usize in_use, peak_in_use;
+} Pool_Stats;
+
+// --------------------------------------------------------------------------------
+
+// Adapted from https://www.gingerbill.org/article/2020/05/31/memory-allocation-strategies-005/
+
+typedef enum _Allocator_Mode {
+    ALLOCATOR_MODE_ALLOC,
+    ALLOCATOR_MODE_RESIZE,
+    ALLOCATOR_MODE_FREE,
+    ALLOCATOR_MODE_FREE_ALL,
+    ALLOCATOR_MODE_COUNT
+} Allocator_Mode;
+
+typedef void *(*Allocator_Proc)(void *data, Allocator_Mode mode, usize size, usize alignment, void *old_mem, usize old_size);
+
+typedef struct _Allocator {
+    Allocator_Proc  proc;
+    void           *data;
+} Allocator;
+
+void *mem_alloc_align(Allocator allocator, usize size, usize alignment) {
+    return allocator.proc(allocator.data, ALLOCATOR_MODE_ALLOC, size, alignment, NULL, 0);
+}
+
+// Because C doesn't have default parameters
+void *mem_alloc(Allocator allocator, usize size) {
+    return mem_alloc_align(allocator, size, ARENA_DEFAULT_ALIGNMENT);
+}
+
+void *mem_resize_align(Allocator allocator, void *mem, usize size, usize new_size, usize alignment) {
+    return allocator.proc(allocator.data, ALLOCATOR_MODE_RESIZE, new_size, alignment, mem, size);
+}
+
+// Because C doesn't have default parameters
+void *mem_resize(Allocator allocator, void *mem, usize size, usize new_size) {
+    return mem_resize_align(allocator, mem, size, new_size, ARENA_DEFAULT_ALIGNMENT);
+}
+
+void mem_free(Allocator allocator, void *mem) {
+    allocator.proc(allocator.data, ALLOCATOR_MODE_FREE, 0, 0, mem, 0);
+}
+
+void mem_free_all(Allocator allocator) {
+    allocator.proc(allocator.data, ALLOCATOR_MODE_FREE_ALL, 0, 0, NULL, 0);
+}
+
+// --------------------------------------------------------------------------------
+
+internal void *heap_allocator_proc(void *data, Allocator_Mode mode, usize size, usize alignment, void *old_mem, usize old_size) {
+    (void)data; (void)alignment; (void)old_size;
+
+    switch (mode) {
+        case ALLOCATOR_MODE_ALLOC:    return malloc(size);
+        case ALLOCATOR_MODE_RESIZE:   return realloc(old_mem, size);
+        case ALLOCATOR_MODE_FREE:     free(old_mem); break;
+        case ALLOCATOR_MODE_FREE_ALL: break; // The heap can't be freed all at once
+        default:                      break;
+    }
+
+    return NULL;
+}
+
+Allocator heap_allocator(void) {
+    Allocator ret;
+    ret.proc = heap_allocator_proc;
+    ret.data = NULL;
+
+    return ret;
+}
+
+// --------------------------------------------------------------------------------
+
 // Adapted from https://www.gingerbill.org/article/2019/02/08/memory-allocation-strategies-002/
 
-typedef struct _Arena {
-    usize  total_size;
-    ubyte *data;
+#define ARENA_FLAG_VIRTUAL        bit(0)
+#define ARENA_FLAG_CHAINED        bit(1)
+
+#define ARENA_COMMIT_SIZE         KB(64)
+#define ARENA_DECOMMIT_THRESHOLD  MB(64)
 
-    usize  prev_offset, cur_offset;
+// Header at the start of every block linked by a chained arena
+typedef struct _Arena_Block {
+    struct _Arena_Block *prev;
+    usize                size;
+
+    // State of the block that was current when this one was pushed
+    ubyte               *prev_data;
+    usize                prev_total_size, prev_prev_offset, prev_cur_offset;
+} Arena_Block;
+
+typedef struct _Arena {
+    usize        total_size;
+    ubyte       *data;
+
+    usize        prev_offset, cur_offset;
+
+    u32          flags;
+    // Only used by virtual arenas, where 'total_size' is the committed size
+    usize        reserve_size;
+    // Only used by chained arenas, where 'data' is the current block
+    usize        block_size;
+    Arena_Block *block, *free_blocks;
+    // Where chained arenas get their blocks from
+    Allocator    parent;
+
+#ifdef MEM_STATS
+    Arena_Stats  stats;
+#endif // MEM_STATS
 } Arena;
 
+internal void _arena_pop_block(Arena *self) {
+    Arena_Block *block = self->block;
+
+    self->data = block->prev_data;
+    self->total_size = block->prev_total_size;
+    self->prev_offset = block->prev_prev_offset;
+    self->cur_offset = block->prev_cur_offset;
+    self->block = block->prev;
+
+    // Keep the block around for the next time the arena grows
+    block->prev = self->free_blocks;
+    self->free_blocks = block;
+}
+
+internal bool _arena_push_block(Arena *self, usize min_size) {
+    Arena_Block **link = &self->free_blocks;
+    while (*link != NULL && (*link)->size < min_size) {
+        link = &(*link)->prev;
+    }
+
+    Arena_Block *block = *link;
+    if (block != NULL) {
+        *link = block->prev;
+    } else {
+        usize size = min_size > self->block_size ? min_size : self->block_size;
+
+        block = (Arena_Block *)mem_alloc(self->parent, sizeof(Arena_Block) + size);
+        if (block == NULL) {
+            return false;
+        }
+
+        block->size = size;
+    }
+
+    block->prev = self->block;
+    block->prev_data = self->data;
+    block->prev_total_size = self->total_size;
+    block->prev_prev_offset = self->prev_offset;
+    block->prev_cur_offset = self->cur_offset;
+
+    self->block = block;
+    self->data = (ubyte *)(block + 1);
+    self->total_size = block->size;
+    self->prev_offset = self->cur_offset = 0;
+
+    return true;
+}
+
+internal void _arena_decommit(Arena *self) {
+    // Keep some committed memory around so that small bursts don't thrash the page tables
+    usize keep = (usize)align_forward(self->cur_offset, ARENA_COMMIT_SIZE) + ARENA_COMMIT_SIZE;
+
+    if (self->total_size > keep && self->total_size - keep >= ARENA_DECOMMIT_THRESHOLD) {
+        madvise(self->data + keep, self->total_size - keep, MADV_DONTNEED);
+        mprotect(self->data + keep, self->total_size - keep, PROT_NONE);
+
+        self->total_size = keep;
+    }
+}
+
 void arena_clear(Arena *self) {
+    while (self->block != NULL) {
+        _arena_pop_block(self);
+    }
+
     self->prev_offset = self->cur_offset = 0;
+
+    if (self->flags & ARENA_FLAG_VIRTUAL) {
+        _arena_decommit(self);
+    }
 }
 
 void arena_init(Arena *self, void *mem, usize total_size) {
     self->total_size = total_size;
     self->data = (ubyte *)mem;
     self->prev_offset = self->cur_offset = 0;
+    self->flags = 0;
+    self->reserve_size = 0;
+    self->block_size = 0;
+    self->block = self->free_blocks = NULL;
+    self->parent.proc = NULL;
+    self->parent.data = NULL;
+
+    mem_stat(memset(&self->stats, 0, sizeof(self->stats)));
+}
+
+// Reserves 'reserve_size' bytes of address space and commits pages as the arena grows
+bool arena_init_virtual(Arena *self, usize reserve_size) {
+    reserve_size = (usize)align_forward(reserve_size, ARENA_COMMIT_SIZE);
+
+    void *mem = mmap(NULL, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+
+    arena_init(self, mem, 0);
+    self->flags = ARENA_FLAG_VIRTUAL;
+    self->reserve_size = reserve_size;
+
+    return true;
+}
+
+// Starts out on 'mem' (which may be NULL) and links further blocks of at least 'block_size' bytes from 'parent'
+// once it fills up. The blocks are handed back to 'parent' by 'arena_release'.
+void arena_init_chained_allocator(Arena *self, void *mem, usize total_size, usize block_size, Allocator parent) {
+    assert(parent.proc != NULL);
+
+    arena_init(self, mem, total_size);
+    self->flags = ARENA_FLAG_CHAINED;
+    self->block_size = block_size;
+    self->parent = parent;
+}
+
+// Because C doesn't have default parameters
+void arena_init_chained(Arena *self, void *mem, usize total_size, usize block_size) {
+    arena_init_chained_allocator(self, mem, total_size, block_size, heap_allocator());
+}
+
+// Gives back memory obtained by the arena itself; caller-provided buffers are left untouched
+void arena_release(Arena *self) {
+    if (self->flags & ARENA_FLAG_VIRTUAL) {
+        munmap(self->data, self->reserve_size);
+    }
+
+    if (self->flags & ARENA_FLAG_CHAINED) {
+        arena_clear(self);
+
+        Arena_Block *next = NULL;
+        for (Arena_Block *block = self->free_blocks; block != NULL; block = next) {
+            next = block->prev;
+            mem_free(self->parent, block);
+        }
+    }
+
+    arena_init(self, NULL, 0);
+}
+
+internal bool _arena_commit(Arena *self, usize min_size) {
+    if (!(self->flags & ARENA_FLAG_VIRTUAL) || min_size > self->reserve_size) {
+        return false;
+    }
+
+    usize new_size = (usize)align_forward(min_size, ARENA_COMMIT_SIZE);
+    if (new_size > self->reserve_size) {
+        new_size = self->reserve_size;
+    }
+
+    if (mprotect(self->data + self->total_size, new_size - self->total_size, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+
+    self->total_size = new_size;
+
+    return true;
 }
 
 void *arena_alloc_align(Arena *self, usize size, usize alignment) {
@@ -72,14 +348,37 @@ void *arena_alloc_align(Arena *self, usize size, usize alignment) {
     // Change to relative offset
     offset -= (uptr)self->data;
 
-    if (offset + size <= self->total_size) {
+    if (offset + size > self->total_size && (self->flags & ARENA_FLAG_CHAINED)) {
+        // Slow path: move on to a block that is guaranteed to fit the aligned allocation
+        if (!_arena_push_block(self, size + alignment)) {
+            mem_stat(++self->stats.num_failed);
+
+            return NULL;
+        }
+
+        offset = align_forward((uptr)self->data, alignment) - (uptr)self->data;
+    }
+
+    if (offset + size <= self->total_size || _arena_commit(self, offset + size)) {
         void *ptr = self->data + offset;
+
+#ifdef MEM_STATS
+        ++self->stats.num_allocs;
+        // Chained arenas start over at offset 0 in every block, so this can't underflow there either
+        self->stats.align_waste += offset > self->cur_offset ? offset - self->cur_offset : 0;
+        if (offset + size > self->stats.peak_offset) {
+            self->stats.peak_offset = offset + size;
+        }
+#endif // MEM_STATS
+
         self->prev_offset = offset;
         self->cur_offset = offset + size;
 
         return ptr;
     }
 
+    mem_stat(++self->stats.num_failed);
+
     return NULL;
 }
 
@@ -88,7 +387,9 @@ void *arena_alloc(Arena *self, usize size) {
     return arena_alloc_align(self, size, ARENA_DEFAULT_ALIGNMENT);
 }
 
-void arena_free(Arena *self, void *ptr) {}
+void arena_free(Arena *self, void *ptr) {
+    (void)self; (void)ptr;
+}
 
 void *arena_resize_align(Arena *self, void *mem, usize size, usize new_size, usize alignment) {
     ubyte *old_mem = (ubyte *)mem;
@@ -100,14 +401,24 @@ void *arena_resize_align(Arena *self, void *mem, usize size, usize new_size, usi
         return arena_alloc_align(self, new_size, alignment);
     }
 
-    if (self->data <= old_mem && old_mem < self->data + self->total_size) {
-        if (self->data + self->prev_offset == old_mem) {
-            self->cur_offset = self->prev_offset + new_size;
+    bool in_block = self->data <= old_mem && old_mem < self->data + self->total_size;
+
+    // Memory from previous blocks of a chained arena can still be moved over to the current one
+    if (in_block || (self->flags & ARENA_FLAG_CHAINED)) {
+        usize end = self->prev_offset + new_size;
+
+        if (in_block && self->data + self->prev_offset == old_mem && (end <= self->total_size || _arena_commit(self, end))) {
+            self->cur_offset = end;
+            mem_stat(self->stats.peak_offset = end > self->stats.peak_offset ? end : self->stats.peak_offset);
 
             return old_mem;
         }
 
         void *new_mem = arena_alloc_align(self, new_size, alignment);
+        if (new_mem == NULL) {
+            return NULL;
+        }
+
         usize copy_size = old_size < new_size ? old_size : new_size;
         // Copy across old memory to the new memory
         memmove(new_mem, old_mem, copy_size);
@@ -126,22 +437,90 @@ void *arena_resize(Arena *self, void *mem, usize size, usize new_size) {
 // --------------------------------------------------------------------------------
 
 typedef struct _Tmp_Arena {
-    Arena  *mem;
-    usize   prev_offset, cur_offset;
+    Arena       *mem;
+    Arena_Block *block;
+    usize        prev_offset, cur_offset;
 } Tmp_Arena;
 
 Tmp_Arena tmp_arena_begin(Arena *mem) {
 	Tmp_Arena ret;
 	ret.mem = mem;
+	ret.block = mem->block;
 	ret.prev_offset = mem->prev_offset;
 	ret.cur_offset = mem->cur_offset;
 
+#ifdef MEM_STATS
+	if (++mem->stats.tmp_depth > mem->stats.peak_tmp_depth) {
+		mem->stats.peak_tmp_depth = mem->stats.tmp_depth;
+	}
+#endif // MEM_STATS
+
 	return ret;
 }
 
 void tmp_arena_end(Tmp_Arena tmp) {
+	// Unwind any blocks pushed since 'tmp_arena_begin'
+	while (tmp.mem->block != tmp.block) {
+		_arena_pop_block(tmp.mem);
+	}
+
 	tmp.mem->prev_offset = tmp.prev_offset;
 	tmp.mem->cur_offset = tmp.cur_offset;
+
+	mem_stat(--tmp.mem->stats.tmp_depth);
+
+	if (tmp.mem->flags & ARENA_FLAG_VIRTUAL) {
+		_arena_decommit(tmp.mem);
+	}
+}
+
+// --------------------------------------------------------------------------------
+
+// Adapted from https://www.rfleury.com/p/untangling-lifetimes-the-arena-allocator
+
+#define SCRATCH_ARENA_COUNT         2
+#define SCRATCH_ARENA_RESERVE_SIZE  GB(8)
+#define SCRATCH_ARENA_BLOCK_SIZE    MB(1)
+
+global per_thread Arena scratch_arenas[SCRATCH_ARENA_COUNT];
+
+// Returns a temporary arena owned by the calling thread which is none of the 'conflicts'.
+// Pass the arenas the caller allocates its results from so that scratch memory never overlaps them.
+Tmp_Arena scratch_begin(Arena **conflicts, usize num_conflicts) {
+    Arena *ret = NULL;
+
+    for (usize i = 0; i < SCRATCH_ARENA_COUNT && ret == NULL; ++i) {
+        ret = &scratch_arenas[i];
+
+        for (usize j = 0; j < num_conflicts; ++j) {
+            if (conflicts[j] == ret) {
+                ret = NULL;
+                break;
+            }
+        }
+    }
+
+    assert(ret != NULL);
+
+    if (ret->flags == 0) {
+        // First use on this thread: fall back to heap blocks where address space can't be reserved
+        if (!arena_init_virtual(ret, SCRATCH_ARENA_RESERVE_SIZE)) {
+            arena_init_chained(ret, NULL, 0, SCRATCH_ARENA_BLOCK_SIZE);
+        }
+    }
+
+    return tmp_arena_begin(ret);
+}
+
+void scratch_end(Tmp_Arena scratch) {
+    tmp_arena_end(scratch);
+}
+
+// Must be called by every thread that used 'scratch_begin' before it exits
+void scratch_release(void) {
+    for (usize i = 0; i < SCRATCH_ARENA_COUNT; ++i) {
+        arena_release(&scratch_arenas[i]);
+    }
 }
 
 // --------------------------------------------------------------------------------
@@ -157,71 +536,1007 @@ typedef struct _Pool {
     ubyte    *data;
 
     usize     chunk_size;
+    // Recycled chunks only; chunks past 'bump_offset' have never been handed out
     Freenode *head;
+    usize     bump_offset;
+
+#ifdef MEM_STATS
+    Pool_Stats stats;
+#endif // MEM_STATS
 } Pool;
 
 void pool_clear(Pool *self) {
+    // Set all chunks to be free without touching them, so that pages are only faulted in once used
+    self->head = NULL;
+    self->bump_offset = 0;
+
+    mem_stat(self->stats.in_use = 0);
+}
+
+void pool_init_align(Pool *self, void *mem, usize size, usize chunk_size, usize chunk_alignment) {
+    // Align backing buffer to the specified chunk alignment
+    uptr initial_start = (uptr)mem;
+    uptr start = align_forward(initial_start, (uptr)chunk_alignment);
+    size -= (usize)(start - initial_start);
+
+    // Align chunk size up to the required chunk alignment
+    chunk_size = (usize)align_forward(chunk_size, chunk_alignment);
+
+    assert(chunk_size >= sizeof(Freenode) && chunk_size <= size);
+
+    self->data = (ubyte *)start;
+    self->total_size = size;
+    self->chunk_size = chunk_size;
+
+    mem_stat(memset(&self->stats, 0, sizeof(self->stats)));
+
+    pool_clear(self);
+}
+
+// Because C doesn't have default parameters
+void pool_init(Pool *self, void *mem, usize size, usize chunk_size) {
+    pool_init_align(self, mem, size, chunk_size, POOL_DEFAULT_ALIGNMENT);
+}
+
+internal void _pool_stat_alloc(Pool *self, usize count) {
+#ifdef MEM_STATS
+    self->stats.num_allocs += count;
+    self->stats.in_use += count;
+    if (self->stats.in_use > self->stats.peak_in_use) {
+        self->stats.peak_in_use = self->stats.in_use;
+    }
+#else
+    (void)self; (void)count;
+#endif // MEM_STATS
+}
+
+void *pool_alloc(Pool *self) {
+    // Get latest free node
+    Freenode *node = self->head;
+
+    if (node == NULL) {
+        // Nothing recycled yet: carve out the next never-used chunk
+        if (self->bump_offset + self->chunk_size > self->total_size) {
+            mem_stat(++self->stats.num_failed);
+            return NULL;
+        }
+
+        node = (Freenode *)(self->data + self->bump_offset);
+        self->bump_offset += self->chunk_size;
+        _pool_stat_alloc(self, 1);
+
+        return node;
+    }
+
+    _pool_stat_alloc(self, 1);
+
+    // Pop free node
+    self->head = self->head->next;
+
+    return node;
+}
+
+void pool_free(Pool *self, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    assert((ubyte *)ptr >= self->data && (ubyte *)ptr < self->data + self->total_size);
+
+    // Push free node
+    Freenode *node = (Freenode *)ptr;
+    node->next = self->head;
+    self->head = node;
+
+    mem_stat(++self->stats.num_frees);
+    mem_stat(--self->stats.in_use);
+}
+
+// Pops up to 'count' chunks into 'ptrs' and returns how many there were
+usize pool_alloc_batch(Pool *self, void **ptrs, usize count) {
+    usize n = 0;
+
+    for (; n < count && self->head != NULL; ++n) {
+        ptrs[n] = self->head;
+        self->head = self->head->next;
+    }
+
+    for (; n < count && self->bump_offset + self->chunk_size <= self->total_size; ++n) {
+        ptrs[n] = self->data + self->bump_offset;
+        self->bump_offset += self->chunk_size;
+    }
+
+    _pool_stat_alloc(self, n);
+    mem_stat(self->stats.num_failed += n < count);
+
+    return n;
+}
+
+void pool_free_batch(Pool *self, void **ptrs, usize count) {
+    for (usize i = 0; i < count; ++i) {
+        pool_free(self, ptrs[i]);
+    }
+}
+
+// --------------------------------------------------------------------------------
+
+#ifdef MEM_STATS
+
+void arena_print_stats(FILE *stream, Arena *self, const char *name) {
+    Arena_Stats *st = &self->stats;
+    usize capacity = (self->flags & ARENA_FLAG_VIRTUAL) ? self->reserve_size : self->total_size;
+
+    fprintf(stream, "\x1b[97m* arena '%s'\033[0m\n", name);
+    fprintf(stream, "peak offset:       %zu of %zu bytes (%.1lf%%)\n",
+            st->peak_offset, capacity, capacity ? 100.0 * (f64)st->peak_offset / (f64)capacity : 0.0);
+    fprintf(stream, "allocations:       %zu (%zu failed)\n", st->num_allocs, st->num_failed);
+    fprintf(stream, "alignment waste:   %zu bytes\n", st->align_waste);
+    fprintf(stream, "tmp arena depth:   %zd (peak %zd)\n", st->tmp_depth, st->peak_tmp_depth);
+
+    if (st->tmp_depth != 0) {
+        fprintf(stream, "\x1b[33mWARNING:\033[0m unbalanced tmp_arena_begin/tmp_arena_end\n");
+    }
+}
+
+void pool_print_stats(FILE *stream, Pool *self, const char *name) {
+    Pool_Stats *st = &self->stats;
     usize num_chunks = self->total_size / self->chunk_size;
-    void *ptr = NULL;
-    Freenode *node = NULL;
 
-    // Set all chunks to be free
-    for (usize i = 0; i < num_chunks; ++i) {
-        ptr = self->data + (i * self->chunk_size);
-        node = (Freenode *)ptr;
-        // Push free node onto thte free list
-        node->next = self->head;
-        self->head = node;
+    fprintf(stream, "\x1b[97m* pool '%s'\033[0m\n", name);
+    fprintf(stream, "chunks in use:     %zu of %zu (peak %zu)\n", st->in_use, num_chunks, st->peak_in_use);
+    fprintf(stream, "allocations:       %zu (%zu failed)\n", st->num_allocs, st->num_failed);
+    fprintf(stream, "frees:             %zu\n", st->num_frees);
+}
+
+#else
+
+#   define arena_print_stats(stream, self, name)
+#   define pool_print_stats(stream, self, name)
+
+#endif // MEM_STATS
+
+// --------------------------------------------------------------------------------
+
+// Lock-free variant of 'Pool' built on a Treiber stack. Free chunks are linked by 32-bit index and
+// the head packs a modification tag next to the index of the top chunk, so that a chunk popped and
+// pushed back by other threads between a load and a CAS (the ABA problem) makes the CAS fail.
+
+#define CACHE_LINE_SIZE  64
+
+typedef struct _Atomic_Pool {
+    usize  total_size;
+    ubyte *data;
+
+    usize  chunk_size;
+
+    // Keep the contended head away from the read-only fields above and from whatever follows
+    ubyte  _pad0[CACHE_LINE_SIZE];
+    u64    head; // (tag << 32) | (chunk index + 1), with index 0 meaning empty
+    // Index of the first never-used chunk; may run past the chunk count once the pool is exhausted
+    u64    bump;
+    ubyte  _pad1[CACHE_LINE_SIZE];
+} Atomic_Pool;
+
+// Not thread-safe: no other thread may use the pool while it is being cleared
+void atomic_pool_clear(Atomic_Pool *self) {
+    u64 tag = (__atomic_load_n(&self->head, __ATOMIC_RELAXED) >> 32) + 1;
+    __atomic_store_n(&self->bump, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->head, tag << 32, __ATOMIC_RELEASE);
+}
+
+// Hands out up to 'count' never-used chunks starting at '*first' and returns how many there were
+internal usize _atomic_pool_bump(Atomic_Pool *self, usize count, ubyte **first) {
+    u64 num_chunks = self->total_size / self->chunk_size;
+
+    if (__atomic_load_n(&self->bump, __ATOMIC_RELAXED) >= num_chunks) {
+        return 0;
+    }
+
+    u64 idx = __atomic_fetch_add(&self->bump, count, __ATOMIC_RELAXED);
+    if (idx >= num_chunks) {
+        return 0;
+    }
+
+    *first = self->data + idx * self->chunk_size;
+
+    return (usize)(idx + count <= num_chunks ? count : num_chunks - idx);
+}
+
+void atomic_pool_init_align(Atomic_Pool *self, void *mem, usize size, usize chunk_size, usize chunk_alignment) {
+    // Align backing buffer to the specified chunk alignment
+    uptr initial_start = (uptr)mem;
+    uptr start = align_forward(initial_start, (uptr)chunk_alignment);
+    size -= (usize)(start - initial_start);
+
+    // Align chunk size up to the required chunk alignment
+    chunk_size = (usize)align_forward(chunk_size, chunk_alignment);
+
+    assert(chunk_size >= sizeof(u32) && chunk_size <= size);
+    assert(size / chunk_size < U32_MAX);
+
+    self->data = (ubyte *)start;
+    self->total_size = size;
+    self->chunk_size = chunk_size;
+    self->head = 0;
+
+    atomic_pool_clear(self);
+}
+
+// Because C doesn't have default parameters
+void atomic_pool_init(Atomic_Pool *self, void *mem, usize size, usize chunk_size) {
+    atomic_pool_init_align(self, mem, size, chunk_size, POOL_DEFAULT_ALIGNMENT);
+}
+
+// Unlike 'pool_alloc', running out of chunks is not a programming error here since other threads
+// may be holding them, so NULL is returned instead
+void *atomic_pool_alloc(Atomic_Pool *self) {
+    u64 head = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+
+    for (;;) {
+        u32 idx = (u32)head;
+        if (idx == 0) {
+            ubyte *chunk = NULL;
+
+            return _atomic_pool_bump(self, 1, &chunk) ? chunk : NULL;
+        }
+
+        ubyte *chunk = self->data + (usize)(idx - 1) * self->chunk_size;
+        // May read a stale link if another thread already took this chunk, in which case the CAS fails
+        u32 next = __atomic_load_n((u32 *)chunk, __ATOMIC_RELAXED);
+        u64 new_head = (((head >> 32) + 1) << 32) | next;
+
+        if (__atomic_compare_exchange_n(&self->head, &head, new_head, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return chunk;
+        }
+    }
+}
+
+void atomic_pool_free(Atomic_Pool *self, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    assert((ubyte *)ptr >= self->data && (ubyte *)ptr < self->data + self->total_size);
+
+    u32 idx = (u32)(((ubyte *)ptr - self->data) / self->chunk_size) + 1;
+    u64 head = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+    u64 new_head;
+
+    do {
+        __atomic_store_n((u32 *)ptr, (u32)head, __ATOMIC_RELAXED);
+        new_head = (((head >> 32) + 1) << 32) | idx;
+    } while (!__atomic_compare_exchange_n(&self->head, &head, new_head, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// Pops up to 'count' chunks with a single CAS and returns how many there were
+usize atomic_pool_alloc_batch(Atomic_Pool *self, void **ptrs, usize count) {
+    u32 num_chunks = (u32)(self->total_size / self->chunk_size);
+    u64 head = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+
+    for (;;) {
+        u32 idx = (u32)head;
+        usize n = 0;
+
+        while (idx != 0 && idx <= num_chunks && n < count) {
+            ubyte *chunk = self->data + (usize)(idx - 1) * self->chunk_size;
+            ptrs[n++] = chunk;
+            idx = __atomic_load_n((u32 *)chunk, __ATOMIC_RELAXED);
+        }
+
+        if (idx > num_chunks) {
+            // Followed a link out of a chunk that some other thread is already using
+            head = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+            continue;
+        }
+
+        if (n == 0) {
+            ubyte *first = NULL;
+            n = _atomic_pool_bump(self, count, &first);
+
+            for (usize i = 0; i < n; ++i) {
+                ptrs[i] = first + i * self->chunk_size;
+            }
+
+            return n;
+        }
+
+        u64 new_head = (((head >> 32) + 1) << 32) | idx;
+
+        if (__atomic_compare_exchange_n(&self->head, &head, new_head, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return n;
+        }
+    }
+}
+
+// Pushes all of 'ptrs' with a single CAS
+void atomic_pool_free_batch(Atomic_Pool *self, void **ptrs, usize count) {
+    if (count == 0) {
+        return;
+    }
+
+    // Link the batch up front so that only its last chunk has to point at the shared head
+    for (usize i = 0; i + 1 < count; ++i) {
+        assert((ubyte *)ptrs[i] >= self->data && (ubyte *)ptrs[i] < self->data + self->total_size);
+
+        *(u32 *)ptrs[i] = (u32)(((ubyte *)ptrs[i + 1] - self->data) / self->chunk_size) + 1;
+    }
+
+    void *last = ptrs[count - 1];
+    u32 first_idx = (u32)(((ubyte *)ptrs[0] - self->data) / self->chunk_size) + 1;
+    u64 head = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+    u64 new_head;
+
+    do {
+        __atomic_store_n((u32 *)last, (u32)head, __ATOMIC_RELAXED);
+        new_head = (((head >> 32) + 1) << 32) | first_idx;
+    } while (!__atomic_compare_exchange_n(&self->head, &head, new_head, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// --------------------------------------------------------------------------------
+
+// Per-thread cache of free chunks in front of an 'Atomic_Pool'. Each thread owns its magazine
+// (e.g. a 'per_thread' global or a worker's local) and only touches the shared pool to refill or
+// flush half a magazine at a time, so steady-state alloc/free pairs stay thread-local.
+
+#define POOL_MAGAZINE_SIZE  64
+
+typedef struct _Pool_Magazine {
+    Atomic_Pool *pool;
+
+    usize        count;
+    void        *chunks[POOL_MAGAZINE_SIZE];
+} Pool_Magazine;
+
+void pool_magazine_init(Pool_Magazine *self, Atomic_Pool *pool) {
+    self->pool = pool;
+    self->count = 0;
+}
+
+void *pool_magazine_alloc(Pool_Magazine *self) {
+    if (self->count == 0) {
+        self->count = atomic_pool_alloc_batch(self->pool, self->chunks, POOL_MAGAZINE_SIZE / 2);
+
+        if (self->count == 0) {
+            return NULL;
+        }
+    }
+
+    return self->chunks[--self->count];
+}
+
+void pool_magazine_free(Pool_Magazine *self, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    if (self->count == POOL_MAGAZINE_SIZE) {
+        // Hand back the older half and keep the most recently freed (cache-hot) chunks
+        atomic_pool_free_batch(self->pool, self->chunks, POOL_MAGAZINE_SIZE / 2);
+        memmove(self->chunks, self->chunks + POOL_MAGAZINE_SIZE / 2, (POOL_MAGAZINE_SIZE / 2) * sizeof(void *));
+        self->count = POOL_MAGAZINE_SIZE / 2;
+    }
+
+    self->chunks[self->count++] = ptr;
+}
+
+// Returns every cached chunk to the shared pool, e.g. before the owning thread exits
+void pool_magazine_flush(Pool_Magazine *self) {
+    atomic_pool_free_batch(self->pool, self->chunks, self->count);
+    self->count = 0;
+}
+
+// --------------------------------------------------------------------------------
+
+// General-purpose allocator for small objects made of one 'Pool' per size class and page. Pages are
+// carved out of a virtual arena aligned to their size, so the page (and thus the size class) of any
+// pointer can be found by masking its address. Requests above SLAB_MAX_SIZE go to the heap.
+
+#define SLAB_PAGE_SIZE     KB(64)
+#define SLAB_MAX_SIZE      KB(8)
+#define SLAB_ALIGNMENT     16
+// 16-byte steps up to 128 bytes, then four steps per power of two up to SLAB_MAX_SIZE
+#define SLAB_NUM_CLASSES   32
+
+typedef struct _Slab_Page {
+    struct _Slab_Page *next;
+    u32                size_class;
+    bool               partial;
+
+    Pool               pool;
+} Slab_Page;
+
+typedef struct _Slab {
+    Arena      pages;
+    // Pages which may still have free chunks, most recently freed into first
+    Slab_Page *partial[SLAB_NUM_CLASSES];
+} Slab;
+
+internal u32 slab_size_class(usize size) {
+    assert(size > 0 && size <= SLAB_MAX_SIZE);
+
+    if (size <= 128) {
+        return (u32)((size + 15) >> 4) - 1;
+    }
+
+    u32 log2 = 63 - (u32)__builtin_clzll((u64)(size - 1));
+    u32 shift = log2 - 2;
+
+    return 8 + (log2 - 7) * 4 + (u32)(((size - 1) >> shift) & 3);
+}
+
+internal usize slab_class_size(u32 size_class) {
+    if (size_class < 8) {
+        return (usize)(size_class + 1) << 4;
+    }
+
+    u32 k = (size_class - 8) / 4, m = (size_class - 8) % 4;
+
+    return (usize)(5 + m) << (k + 5);
+}
+
+bool slab_init(Slab *self, usize reserve_size) {
+    memset(self->partial, 0, sizeof(self->partial));
+
+    return arena_init_virtual(&self->pages, reserve_size);
+}
+
+void slab_release(Slab *self) {
+    arena_release(&self->pages);
+    memset(self->partial, 0, sizeof(self->partial));
+}
+
+void *slab_alloc(Slab *self, usize size) {
+    if (size > SLAB_MAX_SIZE) {
+        return malloc(size);
+    }
+
+    u32 size_class = slab_size_class(size ? size : 1);
+    void *ptr = NULL;
+
+    for (;;) {
+        Slab_Page *page = self->partial[size_class];
+
+        if (page == NULL) {
+            page = (Slab_Page *)arena_alloc_align(&self->pages, SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+            if (page == NULL) {
+                return NULL;
+            }
+
+            page->next = NULL;
+            page->size_class = size_class;
+            page->partial = true;
+            pool_init_align(&page->pool, page + 1, SLAB_PAGE_SIZE - sizeof(Slab_Page),
+                            slab_class_size(size_class), SLAB_ALIGNMENT);
+
+            self->partial[size_class] = page;
+        }
+
+        if (pool_alloc_batch(&page->pool, &ptr, 1)) {
+            return ptr;
+        }
+
+        // Page is full, it will come back once one of its chunks is freed
+        page->partial = false;
+        self->partial[size_class] = page->next;
+    }
+}
+
+void slab_free(Slab *self, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    ubyte *mem = (ubyte *)ptr;
+
+    if (mem < self->pages.data || mem >= self->pages.data + self->pages.reserve_size) {
+        free(ptr);
+        return;
+    }
+
+    Slab_Page *page = (Slab_Page *)((uptr)mem & ~(uptr)(SLAB_PAGE_SIZE - 1));
+    pool_free(&page->pool, ptr);
+
+    if (!page->partial) {
+        page->partial = true;
+        page->next = self->partial[page->size_class];
+        self->partial[page->size_class] = page;
+    }
+}
+
+// Usable size of an allocation, which may be larger than the size it was requested with
+usize slab_size(Slab *self, void *ptr) {
+    ubyte *mem = (ubyte *)ptr;
+    assert(mem >= self->pages.data && mem < self->pages.data + self->pages.reserve_size);
+
+    Slab_Page *page = (Slab_Page *)((uptr)mem & ~(uptr)(SLAB_PAGE_SIZE - 1));
+
+    return page->pool.chunk_size;
+}
+
+void *slab_resize(Slab *self, void *ptr, usize size, usize new_size) {
+    if (ptr == NULL) {
+        return slab_alloc(self, new_size);
+    }
+
+    ubyte *mem = (ubyte *)ptr;
+    bool in_slab = mem >= self->pages.data && mem < self->pages.data + self->pages.reserve_size;
+
+    if (!in_slab && new_size > SLAB_MAX_SIZE) {
+        return realloc(ptr, new_size);
+    }
+
+    if (in_slab && new_size <= slab_size(self, ptr)) {
+        return ptr;
+    }
+
+    void *new_mem = slab_alloc(self, new_size);
+    if (new_mem == NULL) {
+        return NULL;
+    }
+
+    memcpy(new_mem, ptr, size < new_size ? size : new_size);
+    slab_free(self, ptr);
+
+    return new_mem;
+}
+
+// --------------------------------------------------------------------------------
+
+// Binary buddy allocator over a caller-provided buffer. Every block starts with a header holding its
+// order, so that free and resize don't need the size and a block can tell whether its buddy (found by
+// flipping the bit of its own size in its offset) is free and whole, in which case the two coalesce.
+
+#define BUDDY_MIN_BLOCK_SIZE  32
+#define BUDDY_NUM_ORDERS      48
+#define BUDDY_ALIGNMENT       16
+
+typedef struct _Buddy_Block {
+    usize                requested;
+    u32                  order;
+    u32                  free;
+
+    // Only valid while the block is free, overlapping its payload
+    struct _Buddy_Block *prev, *next;
+} Buddy_Block;
+
+#define BUDDY_HEADER_SIZE     offsetof(Buddy_Block, prev)
+
+typedef struct _Buddy {
+    usize        total_size;
+    ubyte       *data;
+
+    Buddy_Block *free_lists[BUDDY_NUM_ORDERS];
+} Buddy;
+
+typedef struct _Buddy_Stats {
+    usize total_size;
+    // Bytes in allocated blocks and bytes actually asked for, the difference being internal fragmentation
+    usize used_size, requested_size;
+    usize free_size, largest_free_size;
+    usize num_allocs, num_free_blocks;
+    // 0 when all free memory is one block, approaching 1 as it is scattered across small blocks
+    f64   external_fragmentation;
+} Buddy_Stats;
+
+internal usize _buddy_block_size(u32 order) {
+    return (usize)BUDDY_MIN_BLOCK_SIZE << order;
+}
+
+// BUDDY_NUM_ORDERS when no block is large enough
+internal u32 _buddy_order(usize size) {
+    u32 order = 0;
+    while (order < BUDDY_NUM_ORDERS && _buddy_block_size(order) < size) {
+        ++order;
+    }
+
+    return order;
+}
+
+internal void _buddy_push(Buddy *self, Buddy_Block *block, u32 order) {
+    block->order = order;
+    block->free = true;
+    block->prev = NULL;
+    block->next = self->free_lists[order];
+
+    if (block->next != NULL) {
+        block->next->prev = block;
+    }
+
+    self->free_lists[order] = block;
+}
+
+internal void _buddy_unlink(Buddy *self, Buddy_Block *block) {
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        self->free_lists[block->order] = block->next;
+    }
+
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+
+    block->free = false;
+}
+
+internal Buddy_Block *_buddy_of(Buddy *self, Buddy_Block *block, u32 order) {
+    usize offset = ((ubyte *)block - self->data) ^ _buddy_block_size(order);
+
+    // Blocks carved from the tail of a buffer whose size is not a power of two may have no buddy
+    if (offset + _buddy_block_size(order) > self->total_size) {
+        return NULL;
+    }
+
+    return (Buddy_Block *)(self->data + offset);
+}
+
+void buddy_clear(Buddy *self) {
+    memset(self->free_lists, 0, sizeof(self->free_lists));
+
+    // Cover the buffer with the largest blocks that fit, each of which ends up without a buddy
+    usize offset = 0;
+    for (u32 order = BUDDY_NUM_ORDERS; order-- > 0;) {
+        while (offset + _buddy_block_size(order) <= self->total_size) {
+            _buddy_push(self, (Buddy_Block *)(self->data + offset), order);
+            offset += _buddy_block_size(order);
+        }
+    }
+}
+
+void buddy_init(Buddy *self, void *mem, usize size) {
+    // Align backing buffer to the block alignment
+    uptr initial_start = (uptr)mem;
+    uptr start = align_forward(initial_start, BUDDY_ALIGNMENT);
+    size -= (usize)(start - initial_start);
+
+    assert(size >= BUDDY_MIN_BLOCK_SIZE);
+
+    self->data = (ubyte *)start;
+    self->total_size = size - size % BUDDY_MIN_BLOCK_SIZE;
+
+    buddy_clear(self);
+}
+
+void *buddy_alloc(Buddy *self, usize size) {
+    // Also keeps 'size + BUDDY_HEADER_SIZE' from wrapping around
+    if (size > _buddy_block_size(BUDDY_NUM_ORDERS - 1)) {
+        return NULL;
+    }
+
+    u32 order = _buddy_order(size + BUDDY_HEADER_SIZE);
+
+    // Find the smallest free block that fits
+    u32 found = order;
+    while (found < BUDDY_NUM_ORDERS && self->free_lists[found] == NULL) {
+        ++found;
+    }
+
+    if (found >= BUDDY_NUM_ORDERS) {
+        return NULL;
+    }
+
+    Buddy_Block *block = self->free_lists[found];
+    _buddy_unlink(self, block);
+
+    // Split it down to size, freeing the upper halves
+    while (found > order) {
+        --found;
+        _buddy_push(self, (Buddy_Block *)((ubyte *)block + _buddy_block_size(found)), found);
+    }
+
+    block->order = order;
+    block->requested = size;
+
+    return (ubyte *)block + BUDDY_HEADER_SIZE;
+}
+
+void buddy_free(Buddy *self, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    assert((ubyte *)ptr >= self->data && (ubyte *)ptr < self->data + self->total_size);
+
+    Buddy_Block *block = (Buddy_Block *)((ubyte *)ptr - BUDDY_HEADER_SIZE);
+    u32 order = block->order;
+
+    assert(!block->free);
+
+    // Coalesce with the buddy for as long as it is free and whole
+    for (;;) {
+        Buddy_Block *buddy = _buddy_of(self, block, order);
+        if (buddy == NULL || !buddy->free || buddy->order != order) {
+            break;
+        }
+
+        _buddy_unlink(self, buddy);
+
+        block = block < buddy ? block : buddy;
+        ++order;
+    }
+
+    _buddy_push(self, block, order);
+}
+
+void *buddy_resize(Buddy *self, void *ptr, usize new_size) {
+    if (ptr == NULL) {
+        return buddy_alloc(self, new_size);
+    }
+
+    if (new_size > _buddy_block_size(BUDDY_NUM_ORDERS - 1)) {
+        return NULL;
+    }
+
+    Buddy_Block *block = (Buddy_Block *)((ubyte *)ptr - BUDDY_HEADER_SIZE);
+    u32 order = block->order;
+    u32 new_order = _buddy_order(new_size + BUDDY_HEADER_SIZE);
+
+    if (new_order <= order) {
+        // Shrink in place, giving back the upper halves
+        while (order > new_order) {
+            --order;
+            _buddy_push(self, (Buddy_Block *)((ubyte *)block + _buddy_block_size(order)), order);
+        }
+
+        block->order = order;
+        block->requested = new_size;
+
+        return ptr;
+    }
+
+    // Grow in place if the block is the lower half of free buddies all the way up to the new order
+    u32 grown = order;
+    while (grown < new_order) {
+        Buddy_Block *buddy = _buddy_of(self, block, grown);
+        if (buddy == NULL || buddy < block || !buddy->free || buddy->order != grown) {
+            break;
+        }
+
+        ++grown;
+    }
+
+    if (grown == new_order) {
+        for (; order < new_order; ++order) {
+            _buddy_unlink(self, _buddy_of(self, block, order));
+        }
+
+        block->order = new_order;
+        block->requested = new_size;
+
+        return ptr;
+    }
+
+    void *new_mem = buddy_alloc(self, new_size);
+    if (new_mem == NULL) {
+        return NULL;
+    }
+
+    memcpy(new_mem, ptr, block->requested);
+    buddy_free(self, ptr);
+
+    return new_mem;
+}
+
+// Walks every block, so it is meant for diagnostics rather than hot paths
+Buddy_Stats buddy_stats(Buddy *self) {
+    Buddy_Stats ret = DEFAULT_VAL;
+    ret.total_size = self->total_size;
+
+    for (usize offset = 0; offset < self->total_size;) {
+        Buddy_Block *block = (Buddy_Block *)(self->data + offset);
+        usize size = _buddy_block_size(block->order);
+
+        if (block->free) {
+            ret.free_size += size;
+            ret.largest_free_size = size > ret.largest_free_size ? size : ret.largest_free_size;
+            ++ret.num_free_blocks;
+        } else {
+            ret.used_size += size;
+            ret.requested_size += block->requested;
+            ++ret.num_allocs;
+        }
+
+        offset += size;
+    }
+
+    if (ret.free_size > 0) {
+        ret.external_fragmentation = 1.0 - (f64)ret.largest_free_size / (f64)ret.free_size;
+    }
+
+    return ret;
+}
+
+// --------------------------------------------------------------------------------
+
+// Backing memory for large arenas and pools, meant to be fed to 'arena_init'/'pool_init_align'.
+// Explicit huge pages are tried first, then transparent huge pages on a huge-page-aligned mapping;
+// either way the memory is usable, just with more TLB misses when neither is available.
+
+#define HUGE_PAGE_SIZE    MB(2)
+#define NUMA_NODE_ANY     (-1)
+
+// From <numaif.h>, to avoid depending on libnuma
+#define _MPOL_PREFERRED   1
+#define _MPOL_MF_MOVE     bit(1)
+
+typedef struct _Page_Mem {
+    ubyte *data;
+    usize  size;
+
+    // Whether the memory comes from the explicit huge page pool rather than transparent huge pages
+    bool   huge_tlb;
+} Page_Mem;
+
+Page_Mem page_mem_alloc(usize size, i32 numa_node) {
+    Page_Mem ret = DEFAULT_VAL;
+    size = (usize)align_forward(size, HUGE_PAGE_SIZE);
+
+    void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif // MAP_HUGETLB
+
+    if (mem != MAP_FAILED) {
+        ret.huge_tlb = true;
+    } else {
+        // Over-map so that the range can be trimmed down to a huge page boundary
+        ubyte *raw = (ubyte *)mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ((void *)raw == MAP_FAILED) {
+            return ret;
+        }
+
+        ubyte *start = (ubyte *)align_forward((uptr)raw, HUGE_PAGE_SIZE);
+        if (start > raw) {
+            munmap(raw, start - raw);
+        }
+
+        munmap(start + size, (raw + size + HUGE_PAGE_SIZE) - (start + size));
+
+#ifdef MADV_HUGEPAGE
+        madvise(start, size, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+
+        mem = start;
+    }
+
+#ifdef SYS_mbind
+    if (numa_node >= 0 && numa_node < 64) {
+        // Preferred rather than strict binding, so that a full node falls back to remote memory
+        unsigned long node_mask = 1ul << numa_node;
+        syscall(SYS_mbind, mem, size, _MPOL_PREFERRED, &node_mask, 64, _MPOL_MF_MOVE);
+    }
+#endif // SYS_mbind
+
+    ret.data = (ubyte *)mem;
+    ret.size = size;
+
+    return ret;
+}
+
+void page_mem_free(Page_Mem mem) {
+    if (mem.data != NULL) {
+        munmap(mem.data, mem.size);
+    }
+}
+
+Page_Mem arena_init_huge(Arena *self, usize size, i32 numa_node) {
+    Page_Mem ret = page_mem_alloc(size, numa_node);
+    arena_init(self, ret.data, ret.data ? ret.size : 0);
+
+    return ret;
+}
+
+// Like 'arena_init_huge', a failed allocation leaves an empty pool whose 'pool_alloc' returns NULL
+Page_Mem pool_init_huge(Pool *self, usize size, usize chunk_size, i32 numa_node) {
+    Page_Mem ret = page_mem_alloc(size, numa_node);
+
+    if (ret.data != NULL) {
+        pool_init(self, ret.data, ret.size, chunk_size);
+    } else {
+        memset(self, 0, sizeof(*self));
+        self->chunk_size = chunk_size;
+    }
+
+    return ret;
+}
+
+// --------------------------------------------------------------------------------
+
+internal void *arena_allocator_proc(void *data, Allocator_Mode mode, usize size, usize alignment, void *old_mem, usize old_size) {
+    Arena *arena = (Arena *)data;
+
+    switch (mode) {
+        case ALLOCATOR_MODE_ALLOC:    return arena_alloc_align(arena, size, alignment);
+        // Extends in place when 'old_mem' was the last allocation
+        case ALLOCATOR_MODE_RESIZE:   return arena_resize_align(arena, old_mem, old_size, size, alignment);
+        case ALLOCATOR_MODE_FREE:     arena_free(arena, old_mem); break;
+        case ALLOCATOR_MODE_FREE_ALL: arena_clear(arena); break;
+        default:                      break;
+    }
+
+    return NULL;
+}
+
+internal void *pool_allocator_proc(void *data, Allocator_Mode mode, usize size, usize alignment, void *old_mem, usize old_size) {
+    Pool *pool = (Pool *)data;
+    (void)alignment; (void)old_size;
+
+    switch (mode) {
+        case ALLOCATOR_MODE_ALLOC:    return size <= pool->chunk_size ? pool_alloc(pool) : NULL;
+        // Every chunk already has the full chunk size
+        case ALLOCATOR_MODE_RESIZE:   return size <= pool->chunk_size ? (old_mem ? old_mem : pool_alloc(pool)) : NULL;
+        case ALLOCATOR_MODE_FREE:     pool_free(pool, old_mem); break;
+        case ALLOCATOR_MODE_FREE_ALL: pool_clear(pool); break;
+        default:                      break;
+    }
+
+    return NULL;
+}
+
+internal void *slab_allocator_proc(void *data, Allocator_Mode mode, usize size, usize alignment, void *old_mem, usize old_size) {
+    Slab *slab = (Slab *)data;
+    (void)alignment;
+
+    assert(alignment <= SLAB_ALIGNMENT);
+
+    switch (mode) {
+        case ALLOCATOR_MODE_ALLOC:    return slab_alloc(slab, size);
+        case ALLOCATOR_MODE_RESIZE:   return slab_resize(slab, old_mem, old_size, size);
+        case ALLOCATOR_MODE_FREE:     slab_free(slab, old_mem); break;
+        case ALLOCATOR_MODE_FREE_ALL: break; // Pages stay with the slab until 'slab_release'
+        default:                      break;
     }
-}
 
-void pool_init_align(Pool *self, void *mem, usize size, usize chunk_size, usize chunk_alignment) {
-    // Align backing buffer to the specified chunk alignment
-    uptr initial_start = (uptr)mem;
-    uptr start = align_forward(initial_start, (uptr)chunk_alignment);
-    size -= (usize)(start - initial_start);
+    return NULL;
+}
 
-    // Align chunk size up to the required chunk alignment
-    chunk_size = (usize)align_forward(chunk_size, chunk_alignment);
+internal void *buddy_allocator_proc(void *data, Allocator_Mode mode, usize size, usize alignment, void *old_mem, usize old_size) {
+    Buddy *buddy = (Buddy *)data;
+    (void)alignment; (void)old_size;
 
-    assert(chunk_size >= sizeof(Freenode) && chunk_size <= size);
+    assert(alignment <= BUDDY_ALIGNMENT);
 
-    self->data = (ubyte *)mem;
-    self->total_size = size;
-    self->chunk_size = chunk_size;
-    self->head = NULL;
+    switch (mode) {
+        case ALLOCATOR_MODE_ALLOC:    return buddy_alloc(buddy, size);
+        case ALLOCATOR_MODE_RESIZE:   return buddy_resize(buddy, old_mem, size);
+        case ALLOCATOR_MODE_FREE:     buddy_free(buddy, old_mem); break;
+        case ALLOCATOR_MODE_FREE_ALL: buddy_clear(buddy); break;
+        default:                      break;
+    }
 
-    // Set up the free list for free chunks
-    pool_clear(self);
+    return NULL;
 }
 
-// Because C doesn't have default parameters
-void pool_init(Pool *self, void *mem, usize size, usize chunk_size) {
-    pool_init_align(self, mem, size, chunk_size, POOL_DEFAULT_ALIGNMENT);
-}
+Allocator arena_allocator(Arena *arena) {
+    Allocator ret;
+    ret.proc = arena_allocator_proc;
+    ret.data = arena;
 
-void *pool_alloc(Pool *self) {
-    // Get latest free node
-    Freenode *node = self->head;
-    assert(node != NULL);
+    return ret;
+}
 
-    // Pop free node
-    self->head = self->head->next;
+Allocator pool_allocator(Pool *pool) {
+    Allocator ret;
+    ret.proc = pool_allocator_proc;
+    ret.data = pool;
 
-    return node;
+    return ret;
 }
 
-void pool_free(Pool *self, void *ptr) {
-    if (ptr == NULL) {
-        return;
-    }
+Allocator slab_allocator(Slab *slab) {
+    Allocator ret;
+    ret.proc = slab_allocator_proc;
+    ret.data = slab;
 
-    assert((ubyte *)ptr >= self->data && (ubyte *)ptr < self->data + self->total_size);
+    return ret;
+}
 
-    // Push free node
-    Freenode *node = (Freenode *)ptr;
-    node->next = self->head;
-    self->head = node;
+Allocator buddy_allocator(Buddy *buddy) {
+    Allocator ret;
+    ret.proc = buddy_allocator_proc;
+    ret.data = buddy;
+
+    return ret;
 }
 
 // --------------------------------------------------------------------------------
@@ -243,13 +1558,25 @@ void pool_free(Pool *self, void *ptr) {
 #define array_remove(a, i)     (((i) >= 0 && (i) < array_count(a)) ? _array_remove(a, i), --_array_count(a), (a) : NULL)
 #define array_concat(a, b, n)  (_array_mgrow(a, n) ? _array_concat(a, b, n), _array_count(a) += (n), (a) : NULL)
 #define array_copy(a, b)       (*((void **)&(a)) = _array_memcpy((b), array_capacity(b), array_count(b), sizeof(*(b))))
+// Stays on 'qsort' so that any comparator works; sort.h has 'array_sort_with' for the inlined sorts
 #define array_sort(a, c)       ((a) ? qsort((a), _array_count(a), sizeof(*(a)), (c)), (a) : NULL)
 #define array_clear(a)         ((a) ? _array_count(a) = 0, (a) : NULL)
-#define array_free(a)          ((a) ? free(_array_header(a)), (a) = NULL, NULL : NULL)
-
-#define _array_header(a)       ((usize *)(a) - 2)
-#define _array_capacity(a)     (_array_header(a)[0])
-#define _array_count(a)        (_array_header(a)[1])
+#define array_free(a)          ((a) ? _array_free(a), (a) = NULL, NULL : NULL)
+// Must be called on a NULL array, arrays created by 'array_push' and friends use the heap
+#define array_init(a, alloc, n) (*((void **)&(a)) = _array_init((alloc), sizeof(*(a)), (n)))
+
+// Storage for an array whose first 'n' elements live in place (e.g. on the stack or inside a struct),
+// spilling to the fallback allocator once it outgrows them. All other array_* macros work as usual.
+// Elements can't need more than 16-byte alignment, or there would be a gap between the header and
+// them; 'array_init_inline' fails to compile for those.
+#define inline_array(T, n)     struct { Inline_Array_Header base; T elems[n]; }
+#define array_init_inline(a, storage, fallback) \
+    ((void)sizeof(char[__alignof__((storage).elems[0]) <= 16 ? 1 : -1]), \
+     *((void **)&(a)) = _array_init_inline(&(storage).base, (fallback), countof((storage).elems)))
+
+#define _array_header(a)       ((Array_Header *)(a) - 1)
+#define _array_capacity(a)     (_array_header(a)->capacity)
+#define _array_count(a)        (_array_header(a)->count)
 #define _array_full(a, n)      (!(a) || _array_count(a) + (n) > _array_capacity(a))
 #define _array_grow(a, n, m)   (*((void **)&(a)) = _array_realloc((a), (n), sizeof(*(a)), (m)))
 #define _array_mgrow(a, n)     (_array_full(a, n) ? (_array_grow(a, n, 0) != 0) : 1)
@@ -257,6 +1584,95 @@ void pool_free(Pool *self, void *ptr) {
 #define _array_remove(a, i)    (memmove((a) + (i), (a) + (i) + 1, (_array_count(a) - 1 - i) * sizeof(*(a))))
 #define _array_concat(a, b, n) (memcpy((a) + _array_count(a), (b), (n) * sizeof(*(b))))
 
+typedef struct _Array_Header {
+    Allocator allocator;
+    usize     capacity, count;
+} Array_Header;
+
+// Precedes the inline elements, which is why its size must keep them aligned
+typedef struct _Inline_Array_Header {
+    Allocator    fallback;
+    Array_Header header;
+} Inline_Array_Header;
+
+// Hands out the fallback allocator's memory but never frees the inline storage
+internal void *inline_allocator_proc(void *data, Allocator_Mode mode, usize size, usize alignment, void *old_mem, usize old_size) {
+    Inline_Array_Header *inl = (Inline_Array_Header *)data;
+    bool is_inline = old_mem == (void *)&inl->header;
+
+    switch (mode) {
+        case ALLOCATOR_MODE_ALLOC: {
+            return mem_alloc_align(inl->fallback, size, alignment);
+        }
+
+        case ALLOCATOR_MODE_RESIZE: {
+            if (!is_inline) {
+                return mem_resize_align(inl->fallback, old_mem, old_size, size, alignment);
+            }
+
+            if (size <= old_size) {
+                return old_mem;
+            }
+
+            // Spill out of the inline storage
+            void *new_mem = mem_alloc_align(inl->fallback, size, alignment);
+            if (new_mem != NULL) {
+                memcpy(new_mem, old_mem, old_size);
+            }
+
+            return new_mem;
+        }
+
+        case ALLOCATOR_MODE_FREE: {
+            if (!is_inline) {
+                mem_free(inl->fallback, old_mem);
+            }
+        } break;
+
+        default: break;
+    }
+
+    return NULL;
+}
+
+internal inline void *_array_init_inline(Inline_Array_Header *inl, Allocator fallback, usize cap) {
+    inl->fallback = fallback;
+    inl->header.allocator.proc = inline_allocator_proc;
+    inl->header.allocator.data = inl;
+    inl->header.capacity = cap;
+    inl->header.count = 0;
+
+    return &inl->header + 1;
+}
+
+// Allocator for copies of an array, which must not depend on the original's inline storage
+internal Allocator _array_copy_allocator(Array_Header *header) {
+    if (header->allocator.proc == inline_allocator_proc) {
+        return ((Inline_Array_Header *)header->allocator.data)->fallback;
+    }
+
+    return header->allocator;
+}
+
+internal void *_array_init(Allocator allocator, usize stride, usize cap) {
+    Array_Header *header = (Array_Header *)mem_alloc(allocator, sizeof(Array_Header) + cap * stride);
+    if (header == NULL) {
+        return NULL;
+    }
+
+    header->allocator = allocator;
+    header->capacity = cap;
+    header->count = 0;
+
+    return header + 1;
+}
+
+internal inline void _array_free(void *arr) {
+    Array_Header *header = _array_header(arr);
+
+    mem_free(header->allocator, header);
+}
+
 internal void *_array_realloc(void *arr, usize num_elems, usize stride, usize min_cap) {
     usize min_count = array_count(arr) + num_elems;
 
@@ -276,14 +1692,22 @@ internal void *_array_realloc(void *arr, usize num_elems, usize stride, usize mi
         min_cap = 2;
     }
 
-    usize *data = (usize *)realloc(arr ? _array_header(arr) : NULL, 2 * sizeof(usize) + min_cap * stride);
-    if (data == NULL) {
+    if (arr == NULL) {
+        return _array_init(heap_allocator(), stride, min_cap);
+    }
+
+    Array_Header *header = _array_header(arr);
+    usize old_size = sizeof(Array_Header) + header->capacity * stride;
+
+    // Arena-backed arrays grow in place when they were the last allocation
+    header = (Array_Header *)mem_resize(header->allocator, header, old_size, sizeof(Array_Header) + min_cap * stride);
+    if (header == NULL) {
         return NULL;
     }
 
-    data[0] = min_cap;
+    header->capacity = min_cap;
 
-    return data + 2;
+    return header + 1;
 }
 
 internal void *_array_memcpy(void *arr, usize cap, usize count, usize stride) {
@@ -291,18 +1715,16 @@ internal void *_array_memcpy(void *arr, usize cap, usize count, usize stride) {
         return NULL;
     }
 
-    usize arr_size = cap * stride;
-
-    usize *data = (usize *)malloc(2 * sizeof(usize) + arr_size);
-    if (data == NULL) {
+    // The copy lives wherever the original does
+    void *ret = _array_init(_array_copy_allocator(_array_header(arr)), stride, cap);
+    if (ret == NULL) {
         return NULL;
     }
 
-    memcpy(data + 2, arr, arr_size);
-    data[0] = cap;
-    data[1] = count;
+    memcpy(ret, arr, count * stride);
+    _array_count(ret) = count;
 
-    return data + 2;
+    return ret;
 }
 
 // --------------------------------------------------------------------------------
@@ -320,23 +1742,16 @@ bool file_exists(const char *path) {
     return true;
 }
 
-i32 file_size(const char *path) {
+// 64-bit, 'ftell' only reports up to 2 GB through an i32
+i64 file_size(const char *path) {
     assert(path != NULL);
 
-    FILE *file = fopen(path, "rb");
-    if (file == NULL) {
+    struct stat s;
+    if (stat(path, &s) != 0) {
         return 0;
     }
 
-    i32 size = 0;
-
-    fseek(file, 0, SEEK_END);
-    size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    fclose(file);
-
-    return size;
+    return (i64)s.st_size;
 }
 
 i64 file_timestamp(const char *path) {
@@ -348,10 +1763,12 @@ i64 file_timestamp(const char *path) {
     return s.st_mtime;
 }
 
-char *file_read_buffer(const char *path, i32 *size, char *buffer) {
+// Reads at most 'buffer_size' - 1 bytes and NUL-terminates them, so a file that grew since its size
+// was checked is cut short rather than overflowing 'buffer'
+char *file_read_buffer(const char *path, i64 *size, char *buffer, usize buffer_size) {
     assert(path != NULL);
     assert(size != NULL);
-    assert(buffer != NULL);
+    assert(buffer != NULL && buffer_size > 0);
 
     FILE *file = fopen(path, "rb");
     if (file == NULL) {
@@ -360,74 +1777,271 @@ char *file_read_buffer(const char *path, i32 *size, char *buffer) {
 
     *size = 0;
 
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    struct stat s;
+    if (fstat(fileno(file), &s) == 0) {
+        usize count = (usize)s.st_size < buffer_size - 1 ? (usize)s.st_size : buffer_size - 1;
+        // Whatever was actually read, in case the file shrank in the meantime
+        *size = (i64)fread(buffer, sizeof(char), count, file);
+    }
 
-    memset(buffer, 0, *size + 1); // TODO(paalf): is this really necessary?
-    fread(buffer, sizeof(char), *size, file);
+    buffer[*size] = '\0';
 
     fclose(file);
 
     return buffer;
 }
 
-char *file_read(const char *path, i32 *size, Arena *mem) {
-    assert(mem != NULL);
-
+char *file_read_allocator(const char *path, i64 *size, Allocator allocator) {
     char *data = NULL;
-    i32 _size = file_size(path);
+    i64 _size = file_size(path);
 
     if (_size > 0) {
-        char *buffer = (char *)arena_alloc(mem, _size + 1);
+        char *buffer = (char *)mem_alloc(allocator, (usize)_size + 1);
+        if (buffer == NULL) {
+            return NULL;
+        }
 
-        data = file_read_buffer(path, size, buffer);
+        data = file_read_buffer(path, size, buffer, (usize)_size + 1);
     }
 
     return data;
 }
 
+char *file_read(const char *path, i64 *size, Arena *mem) {
+    assert(mem != NULL);
+
+    return file_read_allocator(path, size, arena_allocator(mem));
+}
+
+// Read-only view of a whole file through the page cache: nothing is copied, pages are only read in
+// when first touched and other processes mapping the same file share them.
+//
+//     File_Map map = file_map(path, FILE_MAP_SEQUENTIAL | FILE_MAP_WILLNEED);
+//     defer { file_unmap(map); };
+//     parse(map.data, map.size);
+//
+// An empty file maps to 'data' == NULL with 'ok' set, a missing one leaves 'ok' unset. The view stays
+// valid after the file is deleted, but shrinking the file under it faults on the lost pages.
+
+typedef enum _File_Map_Hint {
+    FILE_MAP_NORMAL     = 0,
+    // Aggressive read-ahead, pages behind the reader may be dropped early
+    FILE_MAP_SEQUENTIAL = bit(0),
+    // No read-ahead, for scattered lookups
+    FILE_MAP_RANDOM     = bit(1),
+    // Start reading the whole file in the background right away
+    FILE_MAP_WILLNEED   = bit(2),
+} File_Map_Hint;
+
+typedef struct _File_Map {
+    const char *data;
+    u64         size;
+    bool        ok;
+} File_Map;
+
+File_Map file_map(const char *path, u32 hints) {
+    assert(path != NULL);
+
+    File_Map ret = DEFAULT_VAL;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return ret;
+    }
+
+    struct stat s;
+    if (fstat(fd, &s) != 0 || (u64)s.st_size > (usize)-1) {
+        close(fd);
+        return ret;
+    }
+
+    if (s.st_size > 0) {
+        void *mem = mmap(NULL, (usize)s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED) {
+            close(fd);
+            return ret;
+        }
+
+        if (hints & FILE_MAP_SEQUENTIAL) madvise(mem, (usize)s.st_size, MADV_SEQUENTIAL);
+        if (hints & FILE_MAP_RANDOM)     madvise(mem, (usize)s.st_size, MADV_RANDOM);
+        if (hints & FILE_MAP_WILLNEED)   madvise(mem, (usize)s.st_size, MADV_WILLNEED);
+
+        ret.data = (const char *)mem;
+        ret.size = (u64)s.st_size;
+    }
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+    ret.ok = true;
+
+    return ret;
+}
+
+void file_unmap(File_Map map) {
+    if (map.data != NULL) {
+        munmap((void *)map.data, (usize)map.size);
+    }
+}
+
 bool file_write(const char *path, char *buffer, usize count) {
     assert(path != NULL);
     assert(buffer != NULL);
 
-    FILE *file = fopen(path, "rb");
+    FILE *file = fopen(path, "wb");
     if (file == NULL) {
         return false;
     }
 
-    fwrite(buffer, sizeof(char), count, file);
+    usize written = fwrite(buffer, sizeof(char), count, file);
 
-    fclose(file);
+    // Buffered data can still fail to reach the file on close
+    bool ok = fclose(file) == 0;
 
-    return true;
+    return ok && written == count;
 }
 
-bool file_copy_buffer(const char *src_path, const char *dst_path, char *buffer) {
-    i32 size = 0;
-    char *data = file_read_buffer(src_path, &size, buffer);
+// File copies run in constant memory and, where the kernel allows it, without the bytes ever coming
+// up to user space: 'copy_file_range' first (which may just share the blocks on CoW filesystems),
+// then 'sendfile', then a read/write loop through a small buffer. Each step picks up from where the
+// previous one stopped, so a copy that fails halfway through one method finishes with the next.
+
+#define FILE_COPY_CHUNK_SIZE  MB(1)
+
+// Copies from 'in' to 'out' at '*offset' until the end of the file, returns false if the kernel
+// can't do it (in which case '*offset' tells how far it got)
+internal bool _file_copy_kernel(int in, int out, u64 *offset, u64 size) {
+#ifdef SYS_copy_file_range
+    // Only up to the size from 'stat', files like those in procfs claim to be empty and
+    // 'copy_file_range' believes them
+    while (*offset < size) {
+        loff_t off_in = (loff_t)*offset, off_out = (loff_t)*offset;
+        usize count = size - *offset < GB(1) ? (usize)(size - *offset) : GB(1);
+        isize n = syscall(SYS_copy_file_range, in, &off_in, out, &off_out, count, 0);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
 
-    FILE *file = fopen(dst_path, "wb");
-    if (file == NULL) {
+        *offset += (u64)n;
+    }
+#endif // SYS_copy_file_range
+
+    // The rest (usually nothing) up to the actual end of the file. 'sendfile' writes at the current
+    // position of 'out'.
+    if (lseek(out, (off_t)*offset, SEEK_SET) < 0) {
         return false;
     }
 
-    fclose(file);
+    for (;;) {
+        off_t off_in = (off_t)*offset;
+        isize n = sendfile(out, in, &off_in, GB(1));
 
-    return true;
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n == 0;
+        }
+
+        *offset += (u64)n;
+    }
 }
 
-bool file_copy(const char *src_path, const char *dst_path, Arena *mem) {
-    assert(mem != NULL);
+// Copies from 'in' to 'out' starting at 'offset' through 'buffer', until the end of the file
+internal bool _file_copy_chunked(int in, int out, u64 offset, char *buffer, usize buffer_size) {
+    for (;;) {
+        isize n = pread(in, buffer, buffer_size, (off_t)offset);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n == 0;
+        }
+
+        for (isize written = 0; written < n;) {
+            isize w = pwrite(out, buffer + written, (usize)(n - written), (off_t)(offset + (u64)written));
+
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                return false;
+            }
+
+            written += w;
+        }
+
+        offset += (u64)n;
+    }
+}
+
+// Only allocates the fallback buffer from 'allocator' when the kernel can't do the copy, 'buffer'
+// is used instead when given
+internal bool _file_copy(const char *src_path, const char *dst_path, char *buffer, usize buffer_size, Allocator *allocator) {
+    assert(src_path != NULL);
+    assert(dst_path != NULL);
+
+    int in = open(src_path, O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+
+    struct stat s;
+    if (fstat(in, &s) != 0) {
+        close(in);
+        return false;
+    }
+
+    int out = open(dst_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, s.st_mode & 0777);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
 
-    i32 size = file_size(src_path);
-    if (size > 0) {
-        char *buffer = (char *)arena_alloc(mem, size + 1);
+    u64 offset = 0;
+    bool ok = _file_copy_kernel(in, out, &offset, (u64)s.st_size);
 
-        return file_copy_buffer(src_path, dst_path, buffer);
+    if (!ok && buffer != NULL) {
+        ok = _file_copy_chunked(in, out, offset, buffer, buffer_size);
+    } else if (!ok && allocator != NULL) {
+        buffer = (char *)mem_alloc(*allocator, FILE_COPY_CHUNK_SIZE);
+
+        if (buffer != NULL) {
+            ok = _file_copy_chunked(in, out, offset, buffer, FILE_COPY_CHUNK_SIZE);
+            mem_free(*allocator, buffer);
+        }
     }
 
-    return false;
+    close(in);
+    ok = close(out) == 0 && ok;
+
+    return ok;
+}
+
+// 'buffer' of any size is the last resort when the kernel can't copy the file by itself
+bool file_copy_buffer(const char *src_path, const char *dst_path, char *buffer, usize buffer_size) {
+    assert(buffer != NULL && buffer_size > 0);
+
+    return _file_copy(src_path, dst_path, buffer, buffer_size, NULL);
+}
+
+bool file_copy_allocator(const char *src_path, const char *dst_path, Allocator allocator) {
+    return _file_copy(src_path, dst_path, NULL, 0, &allocator);
+}
+
+bool file_copy(const char *src_path, const char *dst_path, Arena *mem) {
+    assert(mem != NULL);
+
+    // Arenas don't free, so give the fallback buffer back this way
+    Tmp_Arena tmp = tmp_arena_begin(mem);
+    bool ok = file_copy_allocator(src_path, dst_path, arena_allocator(mem));
+    tmp_arena_end(tmp);
+
+    return ok;
 }
 
 // --------------------------------------------------------------------------------
@@ -446,16 +2060,18 @@ void _log(FILE *stream, const char *prefix, const char *fmt, Text_Color color, .
         "\x1b[33m", // TEXT_COLOR_YELLOW
     };
 
-    char fmt_buffer[128];
-    sprintf(fmt_buffer, "%s%s:\033[0m %s\n", text_color_table[color], prefix, fmt);
+    // Written straight to the stream, which has no length limit unlike a fixed buffer, and locked so
+    // the pieces of a message from different threads don't interleave
+    flockfile(stream);
+    fprintf(stream, "%s%s:\033[0m ", text_color_table[color], prefix);
 
-    local char buffer[128];
     va_list args;
     va_start(args, color);
-    vsprintf(buffer, fmt_buffer, args);
+    vfprintf(stream, fmt, args);
     va_end(args);
 
-    fputs(buffer, stream);
+    fputc('\n', stream);
+    funlockfile(stream);
 }
 
 extern FILE *_log_file;
@@ -479,6 +2095,8 @@ extern FILE *_log_file;
 
 #if defined(__cplusplus) && (__cplusplus >= 201103L)
 
+#include <new>
+
 template<typename T> struct Remove_Reference       { typedef T Type; };
 template<typename T> struct Remove_Reference<T &>  { typedef T Type; };
 template<typename T> struct Remove_Reference<T &&> { typedef T Type; };
@@ -487,7 +2105,7 @@ template<typename T> struct Remove_Reference<T &&> { typedef T Type; };
 
 template<typename T> inline T &&forward(typename Remove_Reference<T>::Type &t)  { return static_cast<T &&>(t); }
 template<typename T> inline T &&forward(typename Remove_Reference<T>::Type &&t) { return static_cast<T &&>(t); }
-template<typename T> inline T &&move(T &&t)                                     { return static_cast<typename Remove_Reference<T>::Type &&>(t); }
+template<typename T> inline typename Remove_Reference<T>::Type &&move(T &&t)     { return static_cast<typename Remove_Reference<T>::Type &&>(t); }
 
 // --------------------------------------------------------------------------------
 
@@ -506,6 +2124,277 @@ struct Scope_Exit_Helper {
 
 #define defer const auto &concat(_defer_, __LINE__) = Scope_Exit_Helper() << [&]()
 
+// --------------------------------------------------------------------------------
+
+// Type-safe counterpart of the array_* macros. 'data' points right past the same 'Array_Header', so
+// the macros still work on arrays of trivially copyable types. Growth goes through the allocator in
+// the header: trivially copyable elements are resized in place when possible (e.g. on an arena) and
+// everything else is move-constructed into the new buffer. Arrays can't be copied implicitly, use
+// 'clone' for that.
+
+template<typename T>
+struct Array {
+    T *data;
+
+    Array() : data(NULL) {}
+
+    explicit Array(Allocator allocator, usize cap = 0) : data((T *)_array_init(allocator, sizeof(T), cap)) {}
+
+    Array(Array &&other) : data(other.data) { other.data = NULL; }
+
+    Array &operator=(Array &&other) {
+        if (this != &other) {
+            release();
+            data = other.data;
+            other.data = NULL;
+        }
+
+        return *this;
+    }
+
+    Array(const Array &) = delete;
+    Array &operator=(const Array &) = delete;
+
+    ~Array() { release(); }
+
+    usize count() const    { return data ? _array_count(data) : 0; }
+    usize capacity() const { return data ? _array_capacity(data) : 0; }
+
+    T &operator[](usize i)             { assert(i < count()); return data[i]; }
+    const T &operator[](usize i) const { assert(i < count()); return data[i]; }
+
+    T &last() { assert(count() > 0); return data[count() - 1]; }
+
+    T *begin() { return data; }
+    T *end()   { return data + count(); }
+    const T *begin() const { return data; }
+    const T *end() const   { return data + count(); }
+
+    Allocator allocator() const { return data ? _array_header(data)->allocator : heap_allocator(); }
+
+    bool reserve(usize cap) {
+        if (cap <= capacity()) {
+            return true;
+        }
+
+        if (data == NULL) {
+            data = (T *)_array_init(heap_allocator(), sizeof(T), cap);
+
+            return data != NULL;
+        }
+
+        Array_Header *header = _array_header(data);
+        usize old_size = sizeof(Array_Header) + header->capacity * sizeof(T);
+        usize new_size = sizeof(Array_Header) + cap * sizeof(T);
+
+        if (__is_trivially_copyable(T)) {
+            header = (Array_Header *)mem_resize(header->allocator, header, old_size, new_size);
+            if (header == NULL) {
+                return false;
+            }
+        } else {
+            Array_Header *new_header = (Array_Header *)mem_alloc(header->allocator, new_size);
+            if (new_header == NULL) {
+                return false;
+            }
+
+            *new_header = *header;
+
+            T *new_data = (T *)(new_header + 1);
+            for (usize i = 0; i < header->count; ++i) {
+                new (new_data + i) T(move(data[i]));
+                data[i].~T();
+            }
+
+            mem_free(header->allocator, header);
+            header = new_header;
+        }
+
+        header->capacity = cap;
+        data = (T *)(header + 1);
+
+        return true;
+    }
+
+    template<typename... Args>
+    T *emplace(Args &&...args) {
+        usize n = count();
+
+        if (n == capacity()) {
+            // The arguments may refer to an element of this array, which growing moves or frees, so
+            // build the new element first
+            T tmp(forward<Args>(args)...);
+            if (!reserve(n < 2 ? 2 : 2 * n)) {
+                return NULL;
+            }
+
+            T *ret = new (data + n) T(move(tmp));
+            ++_array_count(data);
+
+            return ret;
+        }
+
+        T *ret = new (data + n) T(forward<Args>(args)...);
+        ++_array_count(data);
+
+        return ret;
+    }
+
+    T *push(const T &elem) { return emplace(elem); }
+    T *push(T &&elem)      { return emplace(move(elem)); }
+
+    void pop() {
+        if (count() > 0) {
+            data[--_array_count(data)].~T();
+        }
+    }
+
+    T *insert(usize i, T &&elem) {
+        usize n = count();
+        assert(i <= n);
+
+        if (i == n) {
+            return emplace(move(elem));
+        }
+
+        if (n == capacity() && !reserve(2 * n)) {
+            return NULL;
+        }
+
+        if (__is_trivially_copyable(T)) {
+            memmove((void *)(data + i + 1), (void *)(data + i), (n - i) * sizeof(T));
+            memcpy((void *)(data + i), (void *)&elem, sizeof(T));
+        } else {
+            new (data + n) T(move(data[n - 1]));
+            for (usize j = n - 1; j > i; --j) {
+                data[j] = move(data[j - 1]);
+            }
+
+            data[i] = move(elem);
+        }
+
+        ++_array_count(data);
+
+        return data + i;
+    }
+
+    T *insert(usize i, const T &elem) { T tmp(elem); return insert(i, move(tmp)); }
+
+    void remove(usize i) {
+        usize n = count();
+        assert(i < n);
+
+        if (__is_trivially_copyable(T)) {
+            memmove((void *)(data + i), (void *)(data + i + 1), (n - 1 - i) * sizeof(T));
+        } else {
+            for (usize j = i; j + 1 < n; ++j) {
+                data[j] = move(data[j + 1]);
+            }
+
+            data[n - 1].~T();
+        }
+
+        --_array_count(data);
+    }
+
+    bool resize(usize n) {
+        if (!reserve(n)) {
+            return false;
+        }
+
+        while (count() > n) {
+            pop();
+        }
+
+        while (count() < n) {
+            emplace();
+        }
+
+        return true;
+    }
+
+    void clear() {
+        while (count() > 0) {
+            pop();
+        }
+    }
+
+    void release() {
+        if (data != NULL) {
+            clear();
+            _array_free(data);
+            data = NULL;
+        }
+    }
+
+    Array clone() const {
+        Array ret(data ? _array_copy_allocator(_array_header(data)) : heap_allocator(), count());
+
+        if (__is_trivially_copyable(T)) {
+            if (count() > 0) {
+                memcpy((void *)ret.data, (const void *)data, count() * sizeof(T));
+                _array_count(ret.data) = count();
+            }
+        } else {
+            for (const T &elem : *this) {
+                ret.emplace(elem);
+            }
+        }
+
+        return ret;
+    }
+};
+
+// --------------------------------------------------------------------------------
+
+// 'Array' whose first N elements live inside the object itself, see 'inline_array'
+template<typename T, usize N>
+struct Small_Array : Array<T> {
+    static_assert(alignof(T) <= 16, "Small_Array elements must not need more than 16-byte alignment");
+
+    struct alignas(16) Storage {
+        Inline_Array_Header base;
+        // Raw bytes, elements are only constructed as they are added
+        ubyte               elems[N * sizeof(T)];
+    } storage;
+
+    explicit Small_Array(Allocator fallback = heap_allocator()) {
+        this->data = (T *)_array_init_inline(&storage.base, fallback, N);
+    }
+
+    Small_Array(Small_Array &&other) : Small_Array(other.storage.base.fallback) { take(other); }
+
+    Small_Array &operator=(Small_Array &&other) {
+        if (this != &other) {
+            this->release();
+            this->data = (T *)_array_init_inline(&storage.base, other.storage.base.fallback, N);
+            take(other);
+        }
+
+        return *this;
+    }
+
+    bool is_inline() const { return (void *)this->data == (void *)storage.elems; }
+
+private:
+    void take(Small_Array &other) {
+        if (other.is_inline()) {
+            for (T &elem : other) {
+                this->emplace(move(elem));
+            }
+
+            other.clear();
+        } else {
+            // Steal the spilled buffer, whose header still refers to the other array's storage
+            this->release();
+            this->data = other.data;
+            _array_header(this->data)->allocator = storage.base.header.allocator;
+
+            other.data = (T *)_array_init_inline(&other.storage.base, other.storage.base.fallback, N);
+        }
+    }
+};
+
 #endif // defined(__cplusplus) && (__cplusplus >= 201103L)
 
 // --------------------------------------------------------------------------------
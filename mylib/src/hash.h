@@ -0,0 +1,354 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include "types.h"
+
+#include <string.h>
+
+#if defined(__AVX512DQ__) || defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(__SSE2__)
+#   include <emmintrin.h>
+#endif // defined(__AVX512DQ__) || defined(__AVX2__)
+
+// --------------------------------------------------------------------------------
+
+// Fast non-cryptographic hashing. 'hash_bytes' is wyhash and 'hash_begin'/'hash_update'/'hash_end'
+// compute the exact same value over data that arrives in pieces. 'hash_u64' is a cheaper mixer for
+// single integers, which 'hash_u64_bulk' applies to many keys at once, several per SIMD register.
+// 'hash_bytes_bulk' does the same for byte strings.
+//
+// None of these resist an attacker who can pick the keys, don't use them for anything security related.
+
+// Adapted from https://github.com/wangyi-fudan/wyhash/blob/master/wyhash.h
+
+global const u64 hash_secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+#define HASH_BLOCK_SIZE  48
+
+// 64x64 -> 128 bit multiplication, leaving the low half in 'a' and the high half in 'b'
+internal void _hash_mum(u64 *a, u64 *b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32), c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif // defined(__SIZEOF_INT128__)
+}
+
+internal u64 _hash_mix(u64 a, u64 b) {
+    _hash_mum(&a, &b);
+
+    return a ^ b;
+}
+
+internal u64 _hash_read8(const ubyte *p) {
+    u64 x;
+    memcpy(&x, p, 8);
+
+    return x;
+}
+
+internal u64 _hash_read4(const ubyte *p) {
+    u32 x;
+    memcpy(&x, p, 4);
+
+    return x;
+}
+
+// Reads 1 to 3 bytes
+internal u64 _hash_read3(const ubyte *p, usize size) {
+    return ((u64)p[0] << 16) | ((u64)p[size >> 1] << 8) | p[size - 1];
+}
+
+internal u64 _hash_seed(u64 seed) {
+    return seed ^ _hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+}
+
+internal u64 _hash_final(u64 a, u64 b, u64 seed, u64 size) {
+    a ^= hash_secret[1];
+    b ^= seed;
+    _hash_mum(&a, &b);
+
+    return _hash_mix(a ^ hash_secret[0] ^ size, b ^ hash_secret[1]);
+}
+
+internal void _hash_block(const ubyte *p, u64 lanes[3]) {
+    lanes[0] = _hash_mix(_hash_read8(p)      ^ hash_secret[1], _hash_read8(p + 8)  ^ lanes[0]);
+    lanes[1] = _hash_mix(_hash_read8(p + 16) ^ hash_secret[2], _hash_read8(p + 24) ^ lanes[1]);
+    lanes[2] = _hash_mix(_hash_read8(p + 32) ^ hash_secret[3], _hash_read8(p + 40) ^ lanes[2]);
+}
+
+// Hashes what is left after the 48-byte blocks, reading up to 16 bytes before 'p' when less than that is left
+internal u64 _hash_tail(const ubyte *p, usize left, u64 seed, u64 size) {
+    while (left > 16) {
+        seed = _hash_mix(_hash_read8(p) ^ hash_secret[1], _hash_read8(p + 8) ^ seed);
+        p += 16;
+        left -= 16;
+    }
+
+    return _hash_final(_hash_read8(p + left - 16), _hash_read8(p + left - 8), seed, size);
+}
+
+// Up to 16 bytes
+internal u64 _hash_short(const ubyte *p, usize size, u64 seed) {
+    u64 a = 0, b = 0;
+
+    if (size >= 4) {
+        a = (_hash_read4(p) << 32) | _hash_read4(p + ((size >> 3) << 2));
+        b = (_hash_read4(p + size - 4) << 32) | _hash_read4(p + size - 4 - ((size >> 3) << 2));
+    } else if (size > 0) {
+        a = _hash_read3(p, size);
+    }
+
+    return _hash_final(a, b, seed, size);
+}
+
+// 'seed' has already gone through '_hash_seed'
+internal u64 _hash_bytes(const ubyte *p, usize size, u64 seed) {
+    if (size <= 16) {
+        return _hash_short(p, size, seed);
+    }
+
+    usize left = size;
+
+    if (left >= HASH_BLOCK_SIZE) {
+        u64 lanes[3] = {seed, seed, seed};
+
+        do {
+            _hash_block(p, lanes);
+            p += HASH_BLOCK_SIZE;
+            left -= HASH_BLOCK_SIZE;
+        } while (left >= HASH_BLOCK_SIZE);
+
+        seed = lanes[0] ^ lanes[1] ^ lanes[2];
+    }
+
+    return _hash_tail(p, left, seed, size);
+}
+
+u64 hash_bytes_seed(const void *data, usize size, u64 seed) {
+    return _hash_bytes((const ubyte *)data, size, _hash_seed(seed));
+}
+
+// Because C doesn't have default parameters
+u64 hash_bytes(const void *data, usize size) {
+    return hash_bytes_seed(data, size, 0);
+}
+
+// Same as 'hash_bytes_seed' on every key. wyhash needs full 64x64 -> 128 bit multiplies, which no SIMD
+// extension has, so the keys are hashed one after another; mixing the seed only once per call still
+// saves one of the two or three multiplies a short key takes.
+void hash_bytes_bulk(const void *const *keys, const usize *sizes, u64 *hashes, usize count, u64 seed) {
+    seed = _hash_seed(seed);
+
+    for (usize i = 0; i < count; ++i) {
+        hashes[i] = _hash_bytes((const ubyte *)keys[i], sizes[i], seed);
+    }
+}
+
+// --------------------------------------------------------------------------------
+
+// Incremental 'hash_bytes_seed'. The last block is held back until more data follows it, since the
+// end of the input is hashed differently, and the 16 bytes before it are kept because the tail may
+// read back into them.
+typedef struct _Hash_State {
+    u64   lanes[3];
+    u64   size;
+    usize pending;
+    ubyte buffer[16 + HASH_BLOCK_SIZE];
+} Hash_State;
+
+void hash_begin(Hash_State *self, u64 seed) {
+    seed = _hash_seed(seed);
+
+    self->lanes[0] = self->lanes[1] = self->lanes[2] = seed;
+    self->size = 0;
+    self->pending = 0;
+}
+
+void hash_update(Hash_State *self, const void *data, usize size) {
+    const ubyte *p = (const ubyte *)data;
+    self->size += size;
+
+    usize n = HASH_BLOCK_SIZE - self->pending;
+    n = n < size ? n : size;
+    memcpy(self->buffer + 16 + self->pending, p, n);
+    self->pending += n;
+    p += n;
+    size -= n;
+
+    if (size == 0) {
+        return;
+    }
+
+    _hash_block(self->buffer + 16, self->lanes);
+
+    // Hash straight from the input, again holding back its last block
+    while (size > HASH_BLOCK_SIZE) {
+        _hash_block(p, self->lanes);
+        p += HASH_BLOCK_SIZE;
+        size -= HASH_BLOCK_SIZE;
+    }
+
+    if (p - (const ubyte *)data >= 16) {
+        memcpy(self->buffer, p - 16, 16);
+    } else {
+        memcpy(self->buffer, self->buffer + HASH_BLOCK_SIZE, 16);
+    }
+
+    memcpy(self->buffer + 16, p, size);
+    self->pending = size;
+}
+
+// Leaves the state as it is, so more data can still be added
+u64 hash_end(Hash_State *self) {
+    const ubyte *p = self->buffer + 16;
+    usize left = self->pending;
+    u64 seed = self->lanes[0];
+
+    if (self->size <= 16) {
+        return _hash_short(p, left, seed);
+    }
+
+    if (self->size >= HASH_BLOCK_SIZE) {
+        u64 lanes[3] = {self->lanes[0], self->lanes[1], self->lanes[2]};
+
+        if (left == HASH_BLOCK_SIZE) {
+            _hash_block(p, lanes);
+            p += HASH_BLOCK_SIZE;
+            left = 0;
+        }
+
+        seed = lanes[0] ^ lanes[1] ^ lanes[2];
+    }
+
+    return _hash_tail(p, left, seed, self->size);
+}
+
+// --------------------------------------------------------------------------------
+
+#define HASH_U64_MUL  0xd6e8feb86659fd93ull
+
+// Bijective xorshift-multiply mixer, every output bit depends on every input bit
+u64 hash_u64_seed(u64 x, u64 seed) {
+    x ^= seed;
+    x ^= x >> 32;
+    x *= HASH_U64_MUL;
+    x ^= x >> 32;
+    x *= HASH_U64_MUL;
+    x ^= x >> 32;
+
+    return x;
+}
+
+// Because C doesn't have default parameters
+u64 hash_u64(u64 x) {
+    return hash_u64_seed(x, 0);
+}
+
+// Same as 'hash_u64_seed' on every key. Only AVX-512 has a 64-bit vector multiply, AVX2 and SSE2 build
+// it from three 32x32 -> 64 bit multiplies, the high halves' product landing entirely above bit 63.
+
+#if defined(__AVX512DQ__)
+
+void hash_u64_bulk(const u64 *keys, u64 *hashes, usize count, u64 seed) {
+    __m512i s = _mm512_set1_epi64((i64)seed);
+    __m512i c = _mm512_set1_epi64((i64)HASH_U64_MUL);
+
+    // The last few keys go through masked loads and stores instead of a scalar loop
+    for (usize i = 0; i < count; i += 8) {
+        __mmask8 mask = count - i >= 8 ? 0xFF : (__mmask8)((1u << (count - i)) - 1);
+
+        __m512i x = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, keys + i), s);
+        x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 32));
+        x = _mm512_mullo_epi64(x, c);
+        x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 32));
+        x = _mm512_mullo_epi64(x, c);
+        x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 32));
+        _mm512_mask_storeu_epi64(hashes + i, mask, x);
+    }
+}
+
+#elif defined(__AVX2__)
+
+// Low 64 bits of 'x' * ('hi' << 32 | 'lo') in every lane
+internal __m256i _hash_mul64_avx2(__m256i x, __m256i lo, __m256i hi) {
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), lo), _mm256_mul_epu32(x, hi));
+
+    return _mm256_add_epi64(_mm256_mul_epu32(x, lo), _mm256_slli_epi64(cross, 32));
+}
+
+void hash_u64_bulk(const u64 *keys, u64 *hashes, usize count, u64 seed) {
+    __m256i s = _mm256_set1_epi64x((i64)seed);
+    __m256i lo = _mm256_set1_epi64x((i64)(HASH_U64_MUL & 0xffffffffull));
+    __m256i hi = _mm256_set1_epi64x((i64)(HASH_U64_MUL >> 32));
+
+    usize i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + i)), s);
+        x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 32));
+        x = _hash_mul64_avx2(x, lo, hi);
+        x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 32));
+        x = _hash_mul64_avx2(x, lo, hi);
+        x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 32));
+        _mm256_storeu_si256((__m256i *)(hashes + i), x);
+    }
+
+    for (; i < count; ++i) {
+        hashes[i] = hash_u64_seed(keys[i], seed);
+    }
+}
+
+#elif defined(__SSE2__)
+
+// Low 64 bits of 'x' * ('hi' << 32 | 'lo') in both lanes
+internal __m128i _hash_mul64_sse2(__m128i x, __m128i lo, __m128i hi) {
+    __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), lo), _mm_mul_epu32(x, hi));
+
+    return _mm_add_epi64(_mm_mul_epu32(x, lo), _mm_slli_epi64(cross, 32));
+}
+
+void hash_u64_bulk(const u64 *keys, u64 *hashes, usize count, u64 seed) {
+    __m128i s = _mm_set1_epi64x((i64)seed);
+    __m128i lo = _mm_set1_epi64x((i64)(HASH_U64_MUL & 0xffffffffull));
+    __m128i hi = _mm_set1_epi64x((i64)(HASH_U64_MUL >> 32));
+
+    usize i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), s);
+        x = _mm_xor_si128(x, _mm_srli_epi64(x, 32));
+        x = _hash_mul64_sse2(x, lo, hi);
+        x = _mm_xor_si128(x, _mm_srli_epi64(x, 32));
+        x = _hash_mul64_sse2(x, lo, hi);
+        x = _mm_xor_si128(x, _mm_srli_epi64(x, 32));
+        _mm_storeu_si128((__m128i *)(hashes + i), x);
+    }
+
+    for (; i < count; ++i) {
+        hashes[i] = hash_u64_seed(keys[i], seed);
+    }
+}
+
+#else
+
+void hash_u64_bulk(const u64 *keys, u64 *hashes, usize count, u64 seed) {
+    for (usize i = 0; i < count; ++i) {
+        hashes[i] = hash_u64_seed(keys[i], seed);
+    }
+}
+
+#endif // defined(__AVX512DQ__)
+
+// --------------------------------------------------------------------------------
+
+#endif // HASH_H
@@ -0,0 +1,580 @@
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include "core.h"
+#include "hash.h"
+
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif // defined(__SSE2__)
+
+// --------------------------------------------------------------------------------
+
+// Open-addressing hash map with a SwissTable-style index: one control byte per slot holds either
+// EMPTY, DELETED or the low 7 bits of the key's hash, and probing compares a whole group of 16
+// control bytes at once. The entries themselves are packed densely in an array preceded by an
+// 'Array_Header', so 'array_count' and a plain loop iterate them; slots only store entry indices.
+//
+//     struct { u64 key; f32 value; } *m = NULL;   // Heap-backed on the first put, or 'hashmap_init'
+//     hashmap_put(m, 42, 1.5f);
+//     if (hashmap_get(m, 42)) ...                // Pointer to the entry or NULL
+//     for (usize i = 0; i < hashmap_count(m); ++i) m[i].key ...
+//
+// Keys are hashed and compared bytewise, so struct keys must not contain padding. Maps must only be
+// modified through hashmap_* (not array_*) and removing an entry moves the last one into its place.
+
+#define HASHMAP_GROUP_SIZE     16
+#define HASHMAP_MIN_SLOTS      16
+
+#define HASHMAP_CTRL_EMPTY     0x80
+#define HASHMAP_CTRL_DELETED   0xFE
+
+#define hashmap_count(m)         array_count(m)
+#define hashmap_capacity(m)      array_capacity(m)
+#define hashmap_reserve(m, n)    ((n) > hashmap_count(m) ? _hashmap_mgrow(m, (n) - hashmap_count(m)) : 1)
+#define hashmap_put(m, k, v)     (_hashmap_mgrow(m, 1) ? _hashmap_temp(m).key = (k), _hashmap_temp(m).value = (v), _hashmap_put((m), _hashmap_args(m)), (m) : NULL)
+#define hashmap_put_entry(m, e)  (_hashmap_mgrow(m, 1) ? _hashmap_temp(m) = (e), _hashmap_put((m), _hashmap_args(m)), (m) : NULL)
+#define hashmap_index(m, k)      ((m) ? _hashmap_temp(m).key = (k), _hashmap_find((m), _hashmap_args(m)) : -1)
+#define hashmap_get(m, k)        (hashmap_index(m, k) >= 0 ? (m) + _hashmap_header(m)->temp : NULL)
+#define hashmap_has(m, k)        (hashmap_index(m, k) >= 0)
+#define hashmap_remove(m, k)     ((m) ? _hashmap_temp(m).key = (k), _hashmap_remove((m), _hashmap_args(m)) : false)
+#define hashmap_clear(m)         ((m) ? _hashmap_clear(m), (m) : NULL)
+#define hashmap_free(m)          ((m) ? _hashmap_free(m), (m) = NULL, NULL : NULL)
+// Must be called on a NULL map, maps created by 'hashmap_put' and friends use the heap
+#define hashmap_init(m, alloc, n) (*((void **)&(m)) = _hashmap_init((alloc), sizeof(*(m)), (n)))
+
+#define _hashmap_header(m)       ((Hash_Map_Header *)((ubyte *)_array_header(m) - offsetof(Hash_Map_Header, header)))
+// Scratch entry right past the last one, where the macros stage keys and values
+#define _hashmap_temp(m)         ((m)[_array_capacity(m)])
+#define _hashmap_args(m)         sizeof(*(m)), (usize)((ubyte *)&(m)->key - (ubyte *)(m)), sizeof((m)->key)
+#define _hashmap_mgrow(m, n)     ((*((void **)&(m)) = _hashmap_grow((m), (n), _hashmap_args(m))) != NULL)
+
+// Control bytes of a group sit right before the entry indices of its slots, so that a hit
+// usually touches one index cache line and then the entry
+typedef struct _Hash_Map_Group {
+    u8  ctrl[HASHMAP_GROUP_SIZE];
+    u32 slots[HASHMAP_GROUP_SIZE];
+} Hash_Map_Group;
+
+// Its size must keep the entries that follow it aligned
+typedef struct _Hash_Map_Header {
+    Hash_Map_Group *groups;
+    usize           num_slots;
+    usize           growth_left;  // Inserts left before the index must be rebuilt, tombstones count as full
+    usize           num_deleted;
+    u64             seed;
+    isize           temp;         // Entry found by the last lookup
+    Array_Header    header;
+} Hash_Map_Header;
+
+// --------------------------------------------------------------------------------
+
+// Each bit of the returned mask is one slot of the group
+
+#if defined(__SSE2__)
+
+internal u32 _hashmap_match(const Hash_Map_Group *group, u8 h2) {
+    __m128i ctrl = _mm_load_si128((const __m128i *)group->ctrl);
+
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+}
+
+// EMPTY and DELETED are the only control bytes with the top bit set
+internal u32 _hashmap_match_free(const Hash_Map_Group *group) {
+    return (u32)_mm_movemask_epi8(_mm_load_si128((const __m128i *)group->ctrl));
+}
+
+#else
+
+internal u32 _hashmap_match(const Hash_Map_Group *group, u8 h2) {
+    u32 mask = 0;
+    for (u32 i = 0; i < HASHMAP_GROUP_SIZE; ++i) {
+        mask |= (u32)(group->ctrl[i] == h2) << i;
+    }
+
+    return mask;
+}
+
+internal u32 _hashmap_match_free(const Hash_Map_Group *group) {
+    u32 mask = 0;
+    for (u32 i = 0; i < HASHMAP_GROUP_SIZE; ++i) {
+        mask |= (u32)(group->ctrl[i] >> 7) << i;
+    }
+
+    return mask;
+}
+
+#endif // defined(__SSE2__)
+
+internal u32 _hashmap_match_empty(const Hash_Map_Group *group) {
+    return _hashmap_match(group, HASHMAP_CTRL_EMPTY);
+}
+
+// --------------------------------------------------------------------------------
+
+// Integer keys skip the general byte hash
+internal u64 _hashmap_hash(const void *key, usize size, u64 seed) {
+    switch (size) {
+        case 4: {
+            u32 x;
+            memcpy(&x, key, 4);
+
+            return hash_u64_seed(x, seed);
+        }
+
+        case 8: {
+            u64 x;
+            memcpy(&x, key, 8);
+
+            return hash_u64_seed(x, seed);
+        }
+
+        default: return hash_bytes_seed(key, size, seed);
+    }
+}
+
+// Small keys compare in registers instead of through a 'memcmp' call
+internal bool _hashmap_key_equal(const ubyte *a, const ubyte *b, usize size) {
+    switch (size) {
+        case 4: {
+            u32 x, y;
+            memcpy(&x, a, 4);
+            memcpy(&y, b, 4);
+
+            return x == y;
+        }
+
+        case 8: {
+            u64 x, y;
+            memcpy(&x, a, 8);
+            memcpy(&y, b, 8);
+
+            return x == y;
+        }
+
+        default: return memcmp(a, b, size) == 0;
+    }
+}
+
+// Up to 7/8 of the slots may be full
+internal usize _hashmap_max_fill(usize num_slots) {
+    return num_slots - num_slots / 8;
+}
+
+// Triangular probing over whole groups, which visits every group once since their number is a power of two
+#define _hashmap_probe_start(h, hash)  ((usize)((hash) >> 7) & ((h)->num_slots / HASHMAP_GROUP_SIZE - 1))
+#define _hashmap_probe_next(h, g, i)   (((g) + (i)) & ((h)->num_slots / HASHMAP_GROUP_SIZE - 1))
+
+#define _hashmap_group(h, slot)        ((h)->groups + (slot) / HASHMAP_GROUP_SIZE)
+#define _hashmap_ctrl(h, slot)         (_hashmap_group(h, slot)->ctrl[(slot) % HASHMAP_GROUP_SIZE])
+#define _hashmap_slot(h, slot)         (_hashmap_group(h, slot)->slots[(slot) % HASHMAP_GROUP_SIZE])
+
+internal isize _hashmap_find_slot(Hash_Map_Header *h, const ubyte *entries, usize stride, usize key_offset, usize key_size, const ubyte *key, u64 hash) {
+    u8 h2 = (u8)(hash & 0x7F);
+    usize g = _hashmap_probe_start(h, hash);
+
+    for (usize i = 1;; ++i) {
+        const Hash_Map_Group *group = h->groups + g;
+
+        for (u32 mask = _hashmap_match(group, h2); mask != 0; mask &= mask - 1) {
+            u32 pos = (u32)__builtin_ctz(mask);
+            if (_hashmap_key_equal(entries + group->slots[pos] * stride + key_offset, key, key_size)) {
+                return (isize)(g * HASHMAP_GROUP_SIZE + pos);
+            }
+        }
+
+        if (_hashmap_match_empty(group) != 0) {
+            return -1;
+        }
+
+        g = _hashmap_probe_next(h, g, i);
+    }
+}
+
+internal void _hashmap_clear_index(Hash_Map_Header *h) {
+    for (usize g = 0; g < h->num_slots / HASHMAP_GROUP_SIZE; ++g) {
+        memset(h->groups[g].ctrl, HASHMAP_CTRL_EMPTY, HASHMAP_GROUP_SIZE);
+    }
+}
+
+// Rebuilds the index from the entries, which drops every tombstone
+internal void _hashmap_rehash(Hash_Map_Header *h, const ubyte *entries, usize stride, usize key_offset, usize key_size) {
+    _hashmap_clear_index(h);
+
+    for (usize e = 0; e < h->header.count; ++e) {
+        u64 hash = _hashmap_hash(entries + e * stride + key_offset, key_size, h->seed);
+        usize g = _hashmap_probe_start(h, hash);
+
+        u32 mask;
+        for (usize i = 1; (mask = _hashmap_match_empty(h->groups + g)) == 0; ++i) {
+            g = _hashmap_probe_next(h, g, i);
+        }
+
+        u32 pos = (u32)__builtin_ctz(mask);
+        h->groups[g].ctrl[pos] = (u8)(hash & 0x7F);
+        h->groups[g].slots[pos] = (u32)e;
+    }
+
+    h->growth_left = _hashmap_max_fill(h->num_slots) - h->header.count;
+    h->num_deleted = 0;
+}
+
+internal void *_hashmap_init(Allocator allocator, usize stride, usize cap) {
+    usize num_slots = HASHMAP_MIN_SLOTS;
+    while (_hashmap_max_fill(num_slots) < cap) {
+        num_slots *= 2;
+    }
+
+    cap = _hashmap_max_fill(num_slots);
+    assert(cap <= U32_MAX);
+
+    // One more entry for '_hashmap_temp'
+    Hash_Map_Header *h = (Hash_Map_Header *)mem_alloc(allocator, sizeof(Hash_Map_Header) + (cap + 1) * stride);
+    if (h == NULL) {
+        return NULL;
+    }
+
+    h->groups = (Hash_Map_Group *)mem_alloc_align(allocator, num_slots / HASHMAP_GROUP_SIZE * sizeof(Hash_Map_Group), HASHMAP_GROUP_SIZE);
+    if (h->groups == NULL) {
+        mem_free(allocator, h);
+        return NULL;
+    }
+
+    h->num_slots = num_slots;
+    h->growth_left = cap;
+    h->num_deleted = 0;
+    // Maps seeded differently don't share collisions, the address is as good a source as any
+    h->seed = hash_u64((u64)(uptr)h);
+    h->temp = -1;
+    h->header.allocator = allocator;
+    h->header.capacity = cap;
+    h->header.count = 0;
+
+    _hashmap_clear_index(h);
+
+    return &h->header + 1;
+}
+
+internal void *_hashmap_grow(void *m, usize num_new, usize stride, usize key_offset, usize key_size) {
+    if (m == NULL) {
+        return _hashmap_init(heap_allocator(), stride, num_new);
+    }
+
+    Hash_Map_Header *h = _hashmap_header(m);
+    if (num_new <= h->growth_left) {
+        return m;
+    }
+
+    usize min_count = h->header.count + num_new;
+    usize num_slots = h->num_slots;
+
+    // Rebuilding in place only pays off when tombstones rather than live entries filled the index
+    if (min_count > num_slots * 25 / 32) {
+        do {
+            num_slots *= 2;
+        } while (_hashmap_max_fill(num_slots) < min_count);
+    }
+
+    if (num_slots != h->num_slots) {
+        Allocator allocator = h->header.allocator;
+        usize cap = _hashmap_max_fill(num_slots);
+        assert(cap <= U32_MAX);
+
+        Hash_Map_Group *groups = (Hash_Map_Group *)mem_alloc_align(allocator, num_slots / HASHMAP_GROUP_SIZE * sizeof(Hash_Map_Group), HASHMAP_GROUP_SIZE);
+        if (groups == NULL) {
+            return NULL;
+        }
+
+        usize old_size = sizeof(Hash_Map_Header) + (h->header.capacity + 1) * stride;
+        Hash_Map_Group *old_groups = h->groups;
+
+        // The index is allocated after the entries, so on an arena this is always a copy rather than
+        // growing in place; the old entries and index stay behind until the arena is cleared
+        h = (Hash_Map_Header *)mem_resize(allocator, h, old_size, sizeof(Hash_Map_Header) + (cap + 1) * stride);
+        if (h == NULL) {
+            mem_free(allocator, groups);
+            return NULL;
+        }
+
+        mem_free(allocator, old_groups);
+
+        h->groups = groups;
+        h->num_slots = num_slots;
+        h->header.capacity = cap;
+    }
+
+    _hashmap_rehash(h, (ubyte *)(&h->header + 1), stride, key_offset, key_size);
+
+    return &h->header + 1;
+}
+
+internal isize _hashmap_find(void *m, usize stride, usize key_offset, usize key_size) {
+    Hash_Map_Header *h = _hashmap_header(m);
+    const ubyte *entries = (const ubyte *)m;
+    const ubyte *key = entries + h->header.capacity * stride + key_offset;
+
+    isize slot = _hashmap_find_slot(h, entries, stride, key_offset, key_size, key, _hashmap_hash(key, key_size, h->seed));
+    h->temp = slot < 0 ? -1 : (isize)_hashmap_slot(h, slot);
+
+    return h->temp;
+}
+
+// Inserts the staged entry or overwrites the one with the same key, the index must have room for it
+internal usize _hashmap_put(void *m, usize stride, usize key_offset, usize key_size) {
+    Hash_Map_Header *h = _hashmap_header(m);
+    ubyte *entries = (ubyte *)m;
+    const ubyte *temp = entries + h->header.capacity * stride;
+    const ubyte *key = temp + key_offset;
+
+    u64 hash = _hashmap_hash(key, key_size, h->seed);
+    u8 h2 = (u8)(hash & 0x7F);
+    usize g = _hashmap_probe_start(h, hash);
+    isize free_slot = -1;
+
+    for (usize i = 1;; ++i) {
+        const Hash_Map_Group *group = h->groups + g;
+
+        for (u32 mask = _hashmap_match(group, h2); mask != 0; mask &= mask - 1) {
+            usize e = group->slots[__builtin_ctz(mask)];
+
+            if (_hashmap_key_equal(entries + e * stride + key_offset, key, key_size)) {
+                memcpy(entries + e * stride, temp, stride);
+                h->temp = (isize)e;
+
+                return e;
+            }
+        }
+
+        // The key can only be further along if this group never had an empty slot
+        u32 free_mask = _hashmap_match_free(group);
+        if (free_slot < 0 && free_mask != 0) {
+            free_slot = (isize)(g * HASHMAP_GROUP_SIZE + (usize)__builtin_ctz(free_mask));
+        }
+
+        if (_hashmap_match_empty(group) != 0) {
+            break;
+        }
+
+        g = _hashmap_probe_next(h, g, i);
+    }
+
+    assert(free_slot >= 0 && h->growth_left > 0);
+
+    if (_hashmap_ctrl(h, free_slot) == HASHMAP_CTRL_EMPTY) {
+        --h->growth_left;
+    } else {
+        --h->num_deleted;
+    }
+
+    usize e = h->header.count++;
+    _hashmap_ctrl(h, free_slot) = h2;
+    _hashmap_slot(h, free_slot) = (u32)e;
+    memcpy(entries + e * stride, temp, stride);
+    h->temp = (isize)e;
+
+    return e;
+}
+
+internal bool _hashmap_remove(void *m, usize stride, usize key_offset, usize key_size) {
+    Hash_Map_Header *h = _hashmap_header(m);
+    ubyte *entries = (ubyte *)m;
+    const ubyte *key = entries + h->header.capacity * stride + key_offset;
+
+    isize slot = _hashmap_find_slot(h, entries, stride, key_offset, key_size, key, _hashmap_hash(key, key_size, h->seed));
+    if (slot < 0) {
+        return false;
+    }
+
+    // Probing stops at the first group with an empty slot, so if this group still has one no probe
+    // ever went past it and the slot can be emptied without leaving a tombstone
+    if (_hashmap_match_empty(_hashmap_group(h, slot)) != 0) {
+        _hashmap_ctrl(h, slot) = HASHMAP_CTRL_EMPTY;
+        ++h->growth_left;
+    } else {
+        _hashmap_ctrl(h, slot) = HASHMAP_CTRL_DELETED;
+        ++h->num_deleted;
+    }
+
+    // Keep the entries packed by moving the last one into the hole
+    usize e = _hashmap_slot(h, slot);
+    usize last = --h->header.count;
+
+    if (e != last) {
+        ubyte *last_entry = entries + last * stride;
+        u64 hash = _hashmap_hash(last_entry + key_offset, key_size, h->seed);
+        u8 h2 = (u8)(hash & 0x7F);
+        usize g = _hashmap_probe_start(h, hash);
+
+        for (usize i = 1;; ++i) {
+            Hash_Map_Group *group = h->groups + g;
+
+            u32 mask = _hashmap_match(group, h2);
+            for (; mask != 0; mask &= mask - 1) {
+                u32 pos = (u32)__builtin_ctz(mask);
+                if (group->slots[pos] == last) {
+                    group->slots[pos] = (u32)e;
+                    break;
+                }
+            }
+
+            if (mask != 0) {
+                break;
+            }
+
+            g = _hashmap_probe_next(h, g, i);
+        }
+
+        memcpy(entries + e * stride, last_entry, stride);
+    }
+
+    h->temp = -1;
+
+    return true;
+}
+
+internal inline void _hashmap_clear(void *m) {
+    Hash_Map_Header *h = _hashmap_header(m);
+
+    _hashmap_clear_index(h);
+    h->growth_left = h->header.capacity;
+    h->num_deleted = 0;
+    h->temp = -1;
+    h->header.count = 0;
+}
+
+internal void _hashmap_free(void *m) {
+    Hash_Map_Header *h = _hashmap_header(m);
+    Allocator allocator = h->header.allocator;
+
+    mem_free(allocator, h->groups);
+    mem_free(allocator, h);
+}
+
+// --------------------------------------------------------------------------------
+
+#if defined(__cplusplus) && (__cplusplus >= 201103L)
+
+template<typename K, typename V>
+struct Hash_Map_Entry {
+    K key;
+    V value;
+};
+
+// Type-safe counterpart of the hashmap_* macros, 'data' is a map those macros accept. Entries are
+// moved around bytewise, which is why keys and values must be trivially copyable.
+template<typename K, typename V>
+struct Hash_Map {
+    typedef Hash_Map_Entry<K, V> Entry;
+
+    static_assert(__is_trivially_copyable(K) && __is_trivially_copyable(V), "Hash_Map keys and values must be trivially copyable");
+
+    Entry *data;
+
+    Hash_Map() : data(NULL) {}
+
+    explicit Hash_Map(Allocator allocator, usize cap = 0) : data((Entry *)_hashmap_init(allocator, sizeof(Entry), cap)) {}
+
+    Hash_Map(Hash_Map &&other) : data(other.data) { other.data = NULL; }
+
+    Hash_Map &operator=(Hash_Map &&other) {
+        if (this != &other) {
+            release();
+            data = other.data;
+            other.data = NULL;
+        }
+
+        return *this;
+    }
+
+    Hash_Map(const Hash_Map &) = delete;
+    Hash_Map &operator=(const Hash_Map &) = delete;
+
+    ~Hash_Map() { release(); }
+
+    usize count() const    { return data ? _array_count(data) : 0; }
+    usize capacity() const { return data ? _array_capacity(data) : 0; }
+
+    Entry *begin() { return data; }
+    Entry *end()   { return data + count(); }
+    const Entry *begin() const { return data; }
+    const Entry *end() const   { return data + count(); }
+
+    bool reserve(usize n) {
+        if (n <= count()) {
+            return data != NULL || n == 0;
+        }
+
+        Entry *ret = (Entry *)_hashmap_grow(data, n - count(), sizeof(Entry), offsetof(Entry, key), sizeof(K));
+        if (ret == NULL) {
+            return false;
+        }
+
+        data = ret;
+
+        return true;
+    }
+
+    V *put(const K &key, const V &value) {
+        if (!reserve(count() + 1)) {
+            return NULL;
+        }
+
+        memcpy((void *)&_hashmap_temp(data).key, (const void *)&key, sizeof(K));
+        memcpy((void *)&_hashmap_temp(data).value, (const void *)&value, sizeof(V));
+
+        return &data[_hashmap_put(data, sizeof(Entry), offsetof(Entry, key), sizeof(K))].value;
+    }
+
+    V *get(const K &key) {
+        if (data == NULL) {
+            return NULL;
+        }
+
+        memcpy((void *)&_hashmap_temp(data).key, (const void *)&key, sizeof(K));
+        isize e = _hashmap_find(data, sizeof(Entry), offsetof(Entry, key), sizeof(K));
+
+        return e < 0 ? NULL : &data[e].value;
+    }
+
+    bool has(const K &key) { return get(key) != NULL; }
+
+    // Inserts a value-initialized entry when the key is missing
+    V &operator[](const K &key) {
+        V *value = get(key);
+        if (value == NULL) {
+            value = put(key, V());
+            assert(value != NULL);
+        }
+
+        return *value;
+    }
+
+    bool remove(const K &key) {
+        if (data == NULL) {
+            return false;
+        }
+
+        memcpy((void *)&_hashmap_temp(data).key, (const void *)&key, sizeof(K));
+
+        return _hashmap_remove(data, sizeof(Entry), offsetof(Entry, key), sizeof(K));
+    }
+
+    void clear() {
+        if (data != NULL) {
+            _hashmap_clear(data);
+        }
+    }
+
+    void release() {
+        if (data != NULL) {
+            _hashmap_free(data);
+            data = NULL;
+        }
+    }
+};
+
+#endif // defined(__cplusplus) && (__cplusplus >= 201103L)
+
+// --------------------------------------------------------------------------------
+
+#endif // HASHMAP_H
@@ -0,0 +1,248 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include "core.h"
+#include "str.h"
+
+#include <pthread.h>
+
+// --------------------------------------------------------------------------------
+
+// String interning: every distinct string is stored once and gets a dense 32-bit ID, so comparing
+// identifiers becomes comparing integers (or canonical pointers, which never move).
+//
+//     Interner interner;
+//     interner_init(&interner, &arena);
+//     u32 a = interner_put(&interner, string_lit("position"));
+//     u32 b = interner_put(&interner, token);       // a == b if 'token' is "position"
+//     interner_get(&interner, a).data;               // NUL-terminated canonical copy
+//
+// Lookups are lock-free and may run on any number of threads while others insert, insertions are
+// serialized by a mutex. Index tables that were outgrown stay where they are so readers still using
+// them remain safe, which costs at most as much memory again as the current one. Everything comes
+// from the arena, which must not be used for anything else while other threads use the interner.
+
+#define INTERNER_INVALID_ID   0xFFFFFFFFu
+#define INTERNER_MIN_SLOTS    64
+// Entries live in chunks that double in size, so the ones already handed out never move
+#define INTERNER_FIRST_CHUNK  256
+#define INTERNER_MAX_CHUNKS   24
+
+// Open-addressing table with linear probing. A slot holds the high half of the hash and ID + 1,
+// zero means empty.
+typedef struct _Interner_Index {
+    usize  mask;
+    u64   *slots;
+} Interner_Index;
+
+typedef struct _Interner {
+    Arena           *arena;
+    pthread_mutex_t  lock;
+
+    Interner_Index  *index;
+    u32              count;
+    String          *chunks[INTERNER_MAX_CHUNKS];
+} Interner;
+
+void interner_init(Interner *self, Arena *arena) {
+    assert(arena != NULL);
+
+    self->arena = arena;
+    pthread_mutex_init(&self->lock, NULL);
+
+    self->index = NULL;
+    self->count = 0;
+    memset(self->chunks, 0, sizeof(self->chunks));
+}
+
+// The memory belongs to the arena and goes away with it
+void interner_release(Interner *self) {
+    pthread_mutex_destroy(&self->lock);
+}
+
+u32 interner_count(Interner *self) {
+    return __atomic_load_n(&self->count, __ATOMIC_ACQUIRE);
+}
+
+internal String *_interner_entry(Interner *self, u32 id) {
+    u32 x = id / INTERNER_FIRST_CHUNK + 1;
+    u32 chunk = 31 - (u32)__builtin_clz(x);
+
+    return &self->chunks[chunk][id - INTERNER_FIRST_CHUNK * ((1u << chunk) - 1)];
+}
+
+// Canonical string of an ID from this interner, stable for the lifetime of the arena
+String interner_get(Interner *self, u32 id) {
+    assert(id < interner_count(self));
+
+    return *_interner_entry(self, id);
+}
+
+internal u32 _interner_find(Interner *self, Interner_Index *index, String s, u64 hash) {
+    if (index == NULL) {
+        return INTERNER_INVALID_ID;
+    }
+
+    u32 tag = (u32)(hash >> 32);
+
+    for (usize i = hash & index->mask;; i = (i + 1) & index->mask) {
+        // Pairs with the release store in '_interner_insert', the entry is complete once its slot is visible
+        u64 slot = __atomic_load_n(&index->slots[i], __ATOMIC_ACQUIRE);
+
+        if (slot == 0) {
+            return INTERNER_INVALID_ID;
+        }
+
+        if ((u32)(slot >> 32) == tag) {
+            u32 id = (u32)slot - 1;
+
+            if (string_equal(*_interner_entry(self, id), s)) {
+                return id;
+            }
+        }
+    }
+}
+
+// ID of 's' if it was interned already, INTERNER_INVALID_ID otherwise. Never blocks.
+u32 interner_find(Interner *self, String s) {
+    Interner_Index *index = __atomic_load_n(&self->index, __ATOMIC_ACQUIRE);
+
+    return _interner_find(self, index, s, string_hash(s));
+}
+
+internal void _interner_index_put(Interner_Index *index, u64 hash, u32 id) {
+    usize i = hash & index->mask;
+
+    while (index->slots[i] != 0) {
+        i = (i + 1) & index->mask;
+    }
+
+    __atomic_store_n(&index->slots[i], (hash >> 32 << 32) | ((u64)id + 1), __ATOMIC_RELEASE);
+}
+
+// Builds a table twice the size next to the current one and publishes it once it is complete
+internal bool _interner_grow(Interner *self) {
+    usize num_slots = self->index ? 2 * (self->index->mask + 1) : INTERNER_MIN_SLOTS;
+
+    Interner_Index *index = (Interner_Index *)arena_alloc(self->arena, sizeof(Interner_Index));
+    u64 *slots = (u64 *)arena_alloc_align(self->arena, num_slots * sizeof(u64), sizeof(u64));
+    if (index == NULL || slots == NULL) {
+        return false;
+    }
+
+    memset(slots, 0, num_slots * sizeof(u64));
+    index->mask = num_slots - 1;
+    index->slots = slots;
+
+    for (u32 id = 0; id < self->count; ++id) {
+        _interner_index_put(index, string_hash(*_interner_entry(self, id)), id);
+    }
+
+    __atomic_store_n(&self->index, index, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+// Needs the lock
+internal u32 _interner_insert(Interner *self, String s, u64 hash) {
+    u32 id = _interner_find(self, self->index, s, hash);
+    if (id != INTERNER_INVALID_ID) {
+        return id;
+    }
+
+    id = self->count;
+    if (id >= INTERNER_FIRST_CHUNK * ((1ull << INTERNER_MAX_CHUNKS) - 1)) {
+        return INTERNER_INVALID_ID;
+    }
+
+    // At most half full, linear probing gets long quickly beyond that
+    if ((self->index == NULL || 2 * ((usize)id + 1) > self->index->mask + 1) && !_interner_grow(self)) {
+        return INTERNER_INVALID_ID;
+    }
+
+    u32 chunk = 31 - (u32)__builtin_clz(id / INTERNER_FIRST_CHUNK + 1);
+    if (self->chunks[chunk] == NULL) {
+        usize size = (usize)INTERNER_FIRST_CHUNK << chunk;
+
+        self->chunks[chunk] = (String *)arena_alloc(self->arena, size * sizeof(String));
+        if (self->chunks[chunk] == NULL) {
+            return INTERNER_INVALID_ID;
+        }
+    }
+
+    char *data = string_to_cstr(s, self->arena);
+    if (data == NULL) {
+        return INTERNER_INVALID_ID;
+    }
+
+    *_interner_entry(self, id) = string_make(data, s.count);
+    _interner_index_put(self->index, hash, id);
+    __atomic_store_n(&self->count, id + 1, __ATOMIC_RELEASE);
+
+    return id;
+}
+
+// ID of 's', interning a copy of it first if it is new. INTERNER_INVALID_ID when the arena is full.
+u32 interner_put(Interner *self, String s) {
+    u64 hash = string_hash(s);
+
+    // Most strings were seen before, so the lock is only taken for new ones
+    Interner_Index *index = __atomic_load_n(&self->index, __ATOMIC_ACQUIRE);
+    u32 id = _interner_find(self, index, s, hash);
+
+    if (id == INTERNER_INVALID_ID) {
+        pthread_mutex_lock(&self->lock);
+        id = _interner_insert(self, s, hash);
+        pthread_mutex_unlock(&self->lock);
+    }
+
+    return id;
+}
+
+// Because C doesn't have default parameters
+u32 interner_put_cstr(Interner *self, const char *cstr) {
+    return interner_put(self, string_from_cstr(cstr));
+}
+
+// Interns every 'sep'-separated token of 'text' (see 'string_split_next'), for example the whole
+// buffer of a 'file_read'. Known tokens are looked up without locking and the lock is taken once,
+// at the first new one. Returns the IDs in token order in an array from 'allocator', or NULL if the
+// arena or the array ran out of memory.
+u32 *interner_put_split(Interner *self, String text, char sep, Allocator allocator) {
+    u32 *ids = NULL;
+    array_init(ids, allocator, 64);
+
+    bool locked = false;
+    String token;
+
+    while (ids && string_split_next(&text, sep, &token)) {
+        u64 hash = string_hash(token);
+        u32 id = _interner_find(self, __atomic_load_n(&self->index, __ATOMIC_ACQUIRE), token, hash);
+
+        if (id == INTERNER_INVALID_ID) {
+            if (!locked) {
+                pthread_mutex_lock(&self->lock);
+                locked = true;
+            }
+
+            id = _interner_insert(self, token, hash);
+
+            if (id == INTERNER_INVALID_ID) {
+                array_free(ids);
+                break;
+            }
+        }
+
+        array_push(ids, id);
+    }
+
+    if (locked) {
+        pthread_mutex_unlock(&self->lock);
+    }
+
+    return ids;
+}
+
+// --------------------------------------------------------------------------------
+
+#endif // INTERN_H
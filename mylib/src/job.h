@@ -0,0 +1,445 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include "core.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+// --------------------------------------------------------------------------------
+
+// Work-stealing job system. A fixed set of workers each own a deque of jobs: a worker pushes and pops
+// its own jobs at the bottom (LIFO, so the data it just touched is still in cache) while idle workers
+// steal from the top of someone else's. The thread calling 'job_system_init' is worker 0 and takes
+// part in the work whenever it waits.
+//
+//     Job_Counter done = {0};
+//     for (...) job_run(&jobs, load_file, &files[i], &done);
+//     job_wait(&jobs, &done);                        // Runs other jobs until all of them finished
+//
+//     job_parallel_for(&jobs, count, 0, update_range, &state);
+//
+// Every job gets its worker's scratch arena, reset to where it was once the job returns, so nested
+// jobs that run while an outer one waits stack on top of its allocations. Jobs may only be submitted
+// and waited for from worker 0 or from inside other jobs.
+
+// Adapted from https://fzn.fr/readings/ppopp13.pdf (Chase-Lev deque for weak memory models)
+
+#define JOB_DEQUE_SIZE              4096
+#define JOB_SYSTEM_MAX_WORKERS      64
+#define JOB_SCRATCH_RESERVE_SIZE    GB(8)
+#define JOB_SCRATCH_BLOCK_SIZE      MB(1)
+// Rounds of looking for work with 'sched_yield' in between before an idle worker goes to sleep
+#define JOB_IDLE_SPINS              32
+
+typedef struct _Job_Counter {
+    u32 pending;
+} Job_Counter;
+
+typedef void (*Job_Proc)(void *data, Arena *scratch);
+typedef void (*Job_For_Proc)(void *data, usize begin, usize end, Arena *scratch);
+
+typedef struct _Job {
+    Job_Proc      proc;
+    void         *data;
+    Job_Counter  *counter;
+
+    // Set instead of 'proc' for a range of a 'job_parallel_for'
+    Job_For_Proc  for_proc;
+    usize         begin, end, grain;
+} Job;
+
+typedef struct _Job_Deque {
+    Job  **buffer;
+    isize  mask;
+
+    ubyte  _pad0[CACHE_LINE_SIZE];
+    // Where thieves take from
+    isize  top;
+    ubyte  _pad1[CACHE_LINE_SIZE];
+    // Only written by the owner
+    isize  bottom;
+    ubyte  _pad2[CACHE_LINE_SIZE];
+} Job_Deque;
+
+typedef struct _Job_Worker {
+    Job_Deque            deque;
+    // Jobs are allocated from and freed to the shared pool through this
+    Pool_Magazine        magazine;
+    Arena                scratch;
+
+    struct _Job_System  *system;
+    pthread_t            thread;
+    u32                  id;
+    u32                  rng;
+} Job_Worker;
+
+typedef struct _Job_System {
+    Job_Worker      *workers;
+    u32              num_workers;
+    Atomic_Pool      jobs;
+
+    // Idle workers sleep until 'epoch' changes, which happens on every push
+    pthread_mutex_t  lock;
+    pthread_cond_t   wake;
+    u32              epoch;
+    u32              num_sleeping;
+    bool             quit;
+} Job_System;
+
+// Worker the calling thread is, NULL outside of a job system
+global per_thread Job_Worker *job_worker;
+
+// --------------------------------------------------------------------------------
+
+internal bool _job_deque_push(Job_Deque *self, Job *job) {
+    isize b = __atomic_load_n(&self->bottom, __ATOMIC_RELAXED);
+    isize t = __atomic_load_n(&self->top, __ATOMIC_ACQUIRE);
+
+    if (b - t > self->mask) {
+        return false;
+    }
+
+    __atomic_store_n(&self->buffer[b & self->mask], job, __ATOMIC_RELAXED);
+    // Pairs with the load of 'bottom' in '_job_deque_steal', a thief sees the job in full
+    __atomic_store_n(&self->bottom, b + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+internal Job *_job_deque_pop(Job_Deque *self) {
+    isize b = __atomic_load_n(&self->bottom, __ATOMIC_RELAXED) - 1;
+    // The paper's fences are folded into sequentially consistent accesses, which compile to the same
+    // instructions on x86 and which thread sanitizers understand
+    __atomic_store_n(&self->bottom, b, __ATOMIC_SEQ_CST);
+    isize t = __atomic_load_n(&self->top, __ATOMIC_SEQ_CST);
+
+    if (t > b) {
+        // Empty
+        __atomic_store_n(&self->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    Job *job = __atomic_load_n(&self->buffer[b & self->mask], __ATOMIC_RELAXED);
+
+    if (t == b) {
+        // Last job, race the thieves for it
+        if (!__atomic_compare_exchange_n(&self->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            job = NULL;
+        }
+
+        __atomic_store_n(&self->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return job;
+}
+
+internal Job *_job_deque_steal(Job_Deque *self) {
+    isize t = __atomic_load_n(&self->top, __ATOMIC_SEQ_CST);
+    isize b = __atomic_load_n(&self->bottom, __ATOMIC_SEQ_CST);
+
+    if (t >= b) {
+        return NULL;
+    }
+
+    Job *job = __atomic_load_n(&self->buffer[t & self->mask], __ATOMIC_RELAXED);
+
+    // Lost against the owner or another thief
+    if (!__atomic_compare_exchange_n(&self->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+
+    return job;
+}
+
+// --------------------------------------------------------------------------------
+
+internal Job *_job_find(Job_Worker *self) {
+    Job *job = _job_deque_pop(&self->deque);
+    if (job != NULL) {
+        return job;
+    }
+
+    // Start at a random victim so thieves don't all line up behind the same worker
+    Job_System *system = self->system;
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 17;
+    self->rng ^= self->rng << 5;
+
+    for (u32 i = 0, v = self->rng % system->num_workers; i < system->num_workers; ++i, v = (v + 1) % system->num_workers) {
+        if (v != self->id && (job = _job_deque_steal(&system->workers[v].deque)) != NULL) {
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+internal void _job_execute(Job_Worker *self, Job *job, bool pooled);
+
+// Makes the job available to thieves, or runs it right away when the deque or the pool is full
+internal void _job_submit(Job_Worker *self, Job *job) {
+    Job_System *system = self->system;
+    Job *pooled = (Job *)pool_magazine_alloc(&self->magazine);
+
+    if (pooled == NULL) {
+        _job_execute(self, job, false);
+        return;
+    }
+
+    *pooled = *job;
+
+    if (!_job_deque_push(&self->deque, pooled)) {
+        _job_execute(self, pooled, true);
+        return;
+    }
+
+    __atomic_add_fetch(&system->epoch, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&system->num_sleeping, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&system->lock);
+        pthread_cond_signal(&system->wake);
+        pthread_mutex_unlock(&system->lock);
+    }
+}
+
+internal void _job_execute(Job_Worker *self, Job *job, bool pooled) {
+    Tmp_Arena scratch = tmp_arena_begin(&self->scratch);
+
+    if (job->for_proc != NULL) {
+        usize begin = job->begin, end = job->end;
+
+        // Keep halving the range, leaving the upper halves for thieves, so big pieces get stolen first
+        while (end - begin > job->grain) {
+            usize mid = begin + (end - begin) / 2;
+
+            Job half = *job;
+            half.begin = mid;
+            half.end = end;
+            __atomic_add_fetch(&job->counter->pending, 1, __ATOMIC_RELAXED);
+            _job_submit(self, &half);
+
+            end = mid;
+        }
+
+        job->for_proc(job->data, begin, end, &self->scratch);
+    } else {
+        job->proc(job->data, &self->scratch);
+    }
+
+    tmp_arena_end(scratch);
+
+    Job_Counter *counter = job->counter;
+    if (pooled) {
+        pool_magazine_free(&self->magazine, job);
+    }
+
+    if (counter != NULL) {
+        // Pairs with the acquire load in 'job_wait', whatever the job wrote is visible once it finished
+        __atomic_sub_fetch(&counter->pending, 1, __ATOMIC_RELEASE);
+    }
+}
+
+internal void *_job_worker_main(void *arg) {
+    Job_Worker *self = (Job_Worker *)arg;
+    Job_System *system = self->system;
+    job_worker = self;
+
+    for (;;) {
+        Job *job = NULL;
+
+        for (u32 spin = 0; spin < JOB_IDLE_SPINS && job == NULL; ++spin) {
+            job = _job_find(self);
+
+            if (job == NULL) {
+                sched_yield();
+            }
+        }
+
+        if (job != NULL) {
+            _job_execute(self, job, true);
+            continue;
+        }
+
+        // Announce going to sleep before the last look, so a push either sees the sleeper or
+        // happens before that look
+        u32 epoch = __atomic_load_n(&system->epoch, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&system->num_sleeping, 1, __ATOMIC_SEQ_CST);
+
+        job = _job_find(self);
+
+        if (job == NULL) {
+            pthread_mutex_lock(&system->lock);
+            while (!system->quit && __atomic_load_n(&system->epoch, __ATOMIC_SEQ_CST) == epoch) {
+                pthread_cond_wait(&system->wake, &system->lock);
+            }
+            pthread_mutex_unlock(&system->lock);
+        }
+
+        __atomic_sub_fetch(&system->num_sleeping, 1, __ATOMIC_SEQ_CST);
+
+        if (job != NULL) {
+            _job_execute(self, job, true);
+        } else if (__atomic_load_n(&system->quit, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+
+    pool_magazine_flush(&self->magazine);
+    // Jobs may have used the thread's own scratch arenas too, e.g. through a radix sort
+    scratch_release();
+    job_worker = NULL;
+
+    return NULL;
+}
+
+// Wakes and joins workers 1 .. 'num_threads' - 1 and frees what 'job_system_init' set up
+internal void _job_system_stop(Job_System *self, u32 num_threads) {
+    pthread_mutex_lock(&self->lock);
+    __atomic_store_n(&self->quit, true, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&self->wake);
+    pthread_mutex_unlock(&self->lock);
+
+    for (u32 i = 1; i < num_threads; ++i) {
+        pthread_join(self->workers[i].thread, NULL);
+    }
+
+    for (u32 i = 0; i < self->num_workers; ++i) {
+        arena_release(&self->workers[i].scratch);
+    }
+
+    pthread_cond_destroy(&self->wake);
+    pthread_mutex_destroy(&self->lock);
+    job_worker = NULL;
+}
+
+// --------------------------------------------------------------------------------
+
+internal u32 _job_default_workers(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? (u32)n : 1;
+}
+
+// Starts 'num_workers' - 1 threads (one per core when 0), the calling thread being worker 0. The
+// deques and the job pool come from 'arena', each worker's scratch arena reserves its own memory.
+// Returns false, with any threads already started stopped again, if one can't be created.
+bool job_system_init(Job_System *self, u32 num_workers, Arena *arena) {
+    assert(job_worker == NULL);
+
+    num_workers = num_workers ? num_workers : _job_default_workers();
+    num_workers = num_workers < JOB_SYSTEM_MAX_WORKERS ? num_workers : JOB_SYSTEM_MAX_WORKERS;
+
+    // One pooled job for every deque slot, a full pool just means running jobs inline
+    usize pool_size = (usize)num_workers * JOB_DEQUE_SIZE * sizeof(Job);
+
+    self->workers = (Job_Worker *)arena_alloc_align(arena, num_workers * sizeof(Job_Worker), CACHE_LINE_SIZE);
+    void *pool_mem = arena_alloc_align(arena, pool_size, CACHE_LINE_SIZE);
+    Job **buffers = (Job **)arena_alloc(arena, (usize)num_workers * JOB_DEQUE_SIZE * sizeof(Job *));
+
+    if (self->workers == NULL || pool_mem == NULL || buffers == NULL) {
+        return false;
+    }
+
+    atomic_pool_init(&self->jobs, pool_mem, pool_size, sizeof(Job));
+
+    self->num_workers = num_workers;
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_cond_init(&self->wake, NULL);
+    self->epoch = 0;
+    self->num_sleeping = 0;
+    self->quit = false;
+
+    for (u32 i = 0; i < num_workers; ++i) {
+        Job_Worker *w = &self->workers[i];
+
+        w->deque.buffer = buffers + (usize)i * JOB_DEQUE_SIZE;
+        w->deque.mask = JOB_DEQUE_SIZE - 1;
+        w->deque.top = w->deque.bottom = 0;
+
+        pool_magazine_init(&w->magazine, &self->jobs);
+
+        // Same fallback as the scratch arenas where address space can't be reserved
+        if (!arena_init_virtual(&w->scratch, JOB_SCRATCH_RESERVE_SIZE)) {
+            arena_init_chained(&w->scratch, NULL, 0, JOB_SCRATCH_BLOCK_SIZE);
+        }
+
+        w->system = self;
+        w->id = i;
+        w->rng = 0x9e3779b9u * (i + 1);
+    }
+
+    job_worker = &self->workers[0];
+
+    for (u32 i = 1; i < num_workers; ++i) {
+        if (pthread_create(&self->workers[i].thread, NULL, _job_worker_main, &self->workers[i]) != 0) {
+            _job_system_stop(self, i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Waits for the workers to finish what is queued and stops them. Only call from worker 0.
+void job_system_release(Job_System *self) {
+    assert(job_worker == &self->workers[0]);
+
+    _job_system_stop(self, self->num_workers);
+}
+
+// Queues 'proc(data, scratch)', adding one to 'counter' (which may be NULL) until it finished
+void job_run(Job_System *self, Job_Proc proc, void *data, Job_Counter *counter) {
+    assert(job_worker != NULL && job_worker->system == self);
+
+    Job job = {proc, data, counter, NULL, 0, 0, 0};
+
+    if (counter != NULL) {
+        __atomic_add_fetch(&counter->pending, 1, __ATOMIC_RELAXED);
+    }
+
+    _job_submit(job_worker, &job);
+}
+
+// Runs queued jobs (this worker's or stolen ones) until every job counted by 'counter' finished
+void job_wait(Job_System *self, Job_Counter *counter) {
+    assert(job_worker != NULL && job_worker->system == self);
+
+    while (__atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) > 0) {
+        Job *job = _job_find(job_worker);
+
+        if (job != NULL) {
+            _job_execute(job_worker, job, true);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+// Calls 'proc(data, begin, end, scratch)' on pieces of at most 'grain' indices covering [0, count)
+// and returns once all of them are done. A 'grain' of 0 makes about 4 pieces per worker.
+void job_parallel_for(Job_System *self, usize count, usize grain, Job_For_Proc proc, void *data) {
+    assert(job_worker != NULL && job_worker->system == self);
+
+    if (count == 0) {
+        return;
+    }
+
+    if (grain == 0) {
+        grain = count / (4 * (usize)self->num_workers);
+    }
+
+    Job_Counter counter = {1};
+    Job job = {NULL, data, &counter, proc, 0, count, grain > 0 ? grain : 1};
+
+    // The calling worker splits the range itself and starts on the first piece
+    _job_execute(job_worker, &job, false);
+    job_wait(self, &counter);
+}
+
+// Same over the elements of an 'array_*' array
+#define job_parallel_for_array(self, a, grain, proc, data)  job_parallel_for((self), array_count(a), (grain), (proc), (data))
+
+// --------------------------------------------------------------------------------
+
+#endif // JOB_H
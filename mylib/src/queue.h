@@ -0,0 +1,276 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "core.h"
+
+// --------------------------------------------------------------------------------
+
+// Bounded lock-free ring buffers for handing messages between threads. Elements are 'stride' bytes
+// copied in and out, the capacity is a power of two and the indices only ever grow, so a slot is
+// found by masking and full/empty are told apart without a wasted slot.
+//
+// The storage comes from the caller, usually an arena:
+//
+//     Spsc_Queue q;
+//     spsc_queue_init_arena(&q, &arena, 1024, sizeof(Message));
+//
+// Larger messages are better allocated from an 'Atomic_Pool' (or 'Pool_Magazine') by the producer
+// and passed as pointers, with the consumer giving them back to the pool, so only 8 bytes go through
+// the queue.
+
+// --------------------------------------------------------------------------------
+
+// Single producer, single consumer. Each side keeps a cached copy of the other side's index and only
+// reads the shared one (a cache miss when the other thread just wrote it) once the cached copy says
+// the queue is full or empty.
+
+// Adapted from https://rigtorp.se/ringbuffer/
+
+typedef struct _Spsc_Queue {
+    ubyte *data;
+    usize  stride;
+    usize  mask;
+
+    ubyte  _pad0[CACHE_LINE_SIZE];
+    // Producer side
+    usize  tail;
+    usize  cached_head;
+    ubyte  _pad1[CACHE_LINE_SIZE];
+    // Consumer side
+    usize  head;
+    usize  cached_tail;
+    ubyte  _pad2[CACHE_LINE_SIZE];
+} Spsc_Queue;
+
+usize spsc_queue_buffer_size(usize capacity, usize stride) {
+    return capacity * stride;
+}
+
+void spsc_queue_init(Spsc_Queue *self, void *mem, usize capacity, usize stride) {
+    assert(capacity > 0 && is_power_of_two(capacity));
+
+    self->data = (ubyte *)mem;
+    self->stride = stride;
+    self->mask = capacity - 1;
+
+    self->tail = self->cached_head = 0;
+    self->head = self->cached_tail = 0;
+}
+
+bool spsc_queue_init_arena(Spsc_Queue *self, Arena *arena, usize capacity, usize stride) {
+    void *mem = arena_alloc_align(arena, spsc_queue_buffer_size(capacity, stride), CACHE_LINE_SIZE);
+    if (mem == NULL) {
+        return false;
+    }
+
+    spsc_queue_init(self, mem, capacity, stride);
+
+    return true;
+}
+
+// Copies 'count' elements between 'elems' and the ring starting at index 'start', wrapping around once
+internal void _queue_copy(ubyte *data, usize mask, usize stride, usize start, ubyte *elems, usize count, bool in) {
+    usize first = start & mask;
+    usize n = mask + 1 - first < count ? mask + 1 - first : count;
+
+    if (in) {
+        memcpy(data + first * stride, elems, n * stride);
+        memcpy(data, elems + n * stride, (count - n) * stride);
+    } else {
+        memcpy(elems, data + first * stride, n * stride);
+        memcpy(elems + n * stride, data, (count - n) * stride);
+    }
+}
+
+// Pushes up to 'count' elements and returns how many fit
+usize spsc_queue_push_batch(Spsc_Queue *self, const void *elems, usize count) {
+    usize tail = self->tail;
+    usize capacity = self->mask + 1;
+
+    if (capacity - (tail - self->cached_head) < count) {
+        // Pairs with the release store in 'spsc_queue_pop_batch', the slots are free to overwrite
+        self->cached_head = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+    }
+
+    usize room = capacity - (tail - self->cached_head);
+    count = count < room ? count : room;
+
+    if (count > 0) {
+        _queue_copy(self->data, self->mask, self->stride, tail, (ubyte *)elems, count, true);
+        __atomic_store_n(&self->tail, tail + count, __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+// Pops up to 'count' elements into 'elems' and returns how many there were
+usize spsc_queue_pop_batch(Spsc_Queue *self, void *elems, usize count) {
+    usize head = self->head;
+
+    if (self->cached_tail - head < count) {
+        self->cached_tail = __atomic_load_n(&self->tail, __ATOMIC_ACQUIRE);
+    }
+
+    usize available = self->cached_tail - head;
+    count = count < available ? count : available;
+
+    if (count > 0) {
+        _queue_copy(self->data, self->mask, self->stride, head, (ubyte *)elems, count, false);
+        __atomic_store_n(&self->head, head + count, __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+// Because C doesn't have default parameters
+bool spsc_queue_push(Spsc_Queue *self, const void *elem) {
+    return spsc_queue_push_batch(self, elem, 1) == 1;
+}
+
+bool spsc_queue_pop(Spsc_Queue *self, void *elem) {
+    return spsc_queue_pop_batch(self, elem, 1) == 1;
+}
+
+// Only a snapshot when the other side is running
+usize spsc_queue_count(Spsc_Queue *self) {
+    return __atomic_load_n(&self->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+}
+
+// --------------------------------------------------------------------------------
+
+// Multiple producers, multiple consumers. Every cell carries a sequence number telling which lap of
+// the ring it is ready for: 'pos' when a producer may write the element of index 'pos', 'pos + 1'
+// once that element is there to be read. Producers and consumers claim indices with a CAS on their
+// shared index and then work on their cells without touching each other.
+
+// Adapted from https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+typedef struct _Mpmc_Queue {
+    // Cells are the sequence number followed by the element
+    ubyte *cells;
+    usize  cell_size;
+    usize  stride;
+    usize  mask;
+
+    ubyte  _pad0[CACHE_LINE_SIZE];
+    usize  tail;
+    ubyte  _pad1[CACHE_LINE_SIZE];
+    usize  head;
+    ubyte  _pad2[CACHE_LINE_SIZE];
+} Mpmc_Queue;
+
+internal usize _mpmc_queue_cell_size(usize stride) {
+    return (usize)align_forward(sizeof(usize) + stride, sizeof(usize));
+}
+
+usize mpmc_queue_buffer_size(usize capacity, usize stride) {
+    return capacity * _mpmc_queue_cell_size(stride);
+}
+
+void mpmc_queue_init(Mpmc_Queue *self, void *mem, usize capacity, usize stride) {
+    assert(capacity > 0 && is_power_of_two(capacity));
+    assert(((uptr)mem & (sizeof(usize) - 1)) == 0);
+
+    self->cells = (ubyte *)mem;
+    self->cell_size = _mpmc_queue_cell_size(stride);
+    self->stride = stride;
+    self->mask = capacity - 1;
+
+    for (usize i = 0; i < capacity; ++i) {
+        *(usize *)(self->cells + i * self->cell_size) = i;
+    }
+
+    self->tail = self->head = 0;
+}
+
+bool mpmc_queue_init_arena(Mpmc_Queue *self, Arena *arena, usize capacity, usize stride) {
+    void *mem = arena_alloc_align(arena, mpmc_queue_buffer_size(capacity, stride), CACHE_LINE_SIZE);
+    if (mem == NULL) {
+        return false;
+    }
+
+    mpmc_queue_init(self, mem, capacity, stride);
+
+    return true;
+}
+
+internal usize *_mpmc_queue_seq(Mpmc_Queue *self, usize pos) {
+    return (usize *)(self->cells + (pos & self->mask) * self->cell_size);
+}
+
+// Claims up to 'count' consecutive indices on 'index' whose cells have the sequence number 'pos + ready',
+// returning how many were claimed and the first one in 'start'
+internal usize _mpmc_queue_claim(Mpmc_Queue *self, usize *index, usize ready, usize count, usize *start) {
+    usize pos = __atomic_load_n(index, __ATOMIC_RELAXED);
+
+    for (;;) {
+        usize n = 0;
+
+        // Pairs with the release store of the sequence number by the other side
+        while (n < count && __atomic_load_n(_mpmc_queue_seq(self, pos + n), __ATOMIC_ACQUIRE) == pos + n + ready) {
+            ++n;
+        }
+
+        if (n == 0) {
+            isize diff = (isize)(__atomic_load_n(_mpmc_queue_seq(self, pos), __ATOMIC_ACQUIRE) - (pos + ready));
+
+            // The cell is a lap behind, so the queue is full (or empty)
+            if (diff < 0) {
+                return 0;
+            }
+
+            // Another thread claimed 'pos' already
+            pos = __atomic_load_n(index, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        if (__atomic_compare_exchange_n(index, &pos, pos + n, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            *start = pos;
+            return n;
+        }
+    }
+}
+
+// Pushes up to 'count' elements with a single CAS and returns how many fit
+usize mpmc_queue_push_batch(Mpmc_Queue *self, const void *elems, usize count) {
+    usize pos;
+    count = _mpmc_queue_claim(self, &self->tail, 0, count, &pos);
+
+    for (usize i = 0; i < count; ++i) {
+        usize *seq = _mpmc_queue_seq(self, pos + i);
+
+        memcpy(seq + 1, (const ubyte *)elems + i * self->stride, self->stride);
+        __atomic_store_n(seq, pos + i + 1, __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+// Pops up to 'count' elements into 'elems' with a single CAS and returns how many there were
+usize mpmc_queue_pop_batch(Mpmc_Queue *self, void *elems, usize count) {
+    usize pos;
+    count = _mpmc_queue_claim(self, &self->head, 1, count, &pos);
+
+    for (usize i = 0; i < count; ++i) {
+        usize *seq = _mpmc_queue_seq(self, pos + i);
+
+        memcpy((ubyte *)elems + i * self->stride, seq + 1, self->stride);
+        // Ready for the producer one lap later
+        __atomic_store_n(seq, pos + i + self->mask + 1, __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+// Because C doesn't have default parameters
+bool mpmc_queue_push(Mpmc_Queue *self, const void *elem) {
+    return mpmc_queue_push_batch(self, elem, 1) == 1;
+}
+
+bool mpmc_queue_pop(Mpmc_Queue *self, void *elem) {
+    return mpmc_queue_pop_batch(self, elem, 1) == 1;
+}
+
+// --------------------------------------------------------------------------------
+
+#endif // QUEUE_H
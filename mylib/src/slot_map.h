@@ -0,0 +1,192 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include "core.h"
+
+// --------------------------------------------------------------------------------
+
+// Slot map: values are packed at the front of a dense array, so iterating them is a linear scan,
+// and callers hold on to handles instead of pointers. A handle names a slot plus the generation the
+// slot had when the value was inserted; removing the value bumps the generation, so stale handles
+// are caught instead of dangling. Slots come from a 'Pool', with the generation kept next to the
+// pool's free list link so it survives the slot being recycled.
+//
+//     Slot_Map entities;
+//     slot_map_init(&entities, mem, size, sizeof(Entity));
+//     Slot_Handle h;
+//     Entity *e = (Entity *)slot_map_alloc(&entities, &h);
+//     ...
+//     Entity *all = (Entity *)entities.data;
+//     for (u32 i = 0; i < entities.count; ++i) all[i] ...
+//     slot_map_remove(&entities, h);                  // Moves the last value into the hole
+//     slot_map_get(&entities, h) == NULL
+//
+// Insert, lookup and remove are O(1). Pointers into 'data' stay valid until the next removal.
+
+typedef struct _Slot_Handle {
+    u32 index;
+    // Never 0 for a live value, so a zeroed handle is always invalid
+    u32 generation;
+} Slot_Handle;
+
+typedef struct _Slot_Map_Slot {
+    // Used by the pool while the slot is free
+    Freenode node;
+    u32      generation;
+    // Position of the value in the dense array
+    u32      dense;
+} Slot_Map_Slot;
+
+typedef struct _Slot_Map {
+    ubyte *data;
+    usize  stride;
+    u32    count, capacity;
+
+    // Slot of every value in 'data', to fix up the handle of the value moved by a removal
+    u32   *dense_slots;
+    Pool   slots;
+} Slot_Map;
+
+// Bytes 'slot_map_init' needs to hold 'capacity' values
+usize slot_map_buffer_size(u32 capacity, usize stride) {
+    return (usize)capacity * (stride + sizeof(u32) + sizeof(Slot_Map_Slot)) + 3 * ARENA_DEFAULT_ALIGNMENT;
+}
+
+// Splits 'mem' into the dense values, their slot indices and the slots, as many of each as fit
+void slot_map_init(Slot_Map *self, void *mem, usize size, usize stride) {
+    usize capacity = size > 3 * ARENA_DEFAULT_ALIGNMENT ? (size - 3 * ARENA_DEFAULT_ALIGNMENT) / (stride + sizeof(u32) + sizeof(Slot_Map_Slot)) : 0;
+    capacity = capacity < 0xFFFFFFFFu ? capacity : 0xFFFFFFFFu;
+
+    assert(capacity > 0);
+
+    uptr p = align_forward((uptr)mem, ARENA_DEFAULT_ALIGNMENT);
+    self->data = (ubyte *)p;
+    p = align_forward(p + capacity * stride, ARENA_DEFAULT_ALIGNMENT);
+    self->dense_slots = (u32 *)p;
+    p = align_forward(p + capacity * sizeof(u32), ARENA_DEFAULT_ALIGNMENT);
+
+    self->stride = stride;
+    self->count = 0;
+    self->capacity = (u32)capacity;
+
+    // Pointer alignment leaves the slot size as it is, so slots can be indexed as a plain array
+    pool_init_align(&self->slots, (void *)p, capacity * sizeof(Slot_Map_Slot), sizeof(Slot_Map_Slot), sizeof(void *));
+}
+
+internal Slot_Map_Slot *_slot_map_slot(Slot_Map *self, u32 index) {
+    return (Slot_Map_Slot *)self->slots.data + index;
+}
+
+// Room for a new value at the end of the dense array, or NULL when the map is full. The value is
+// left uninitialized.
+void *slot_map_alloc(Slot_Map *self, Slot_Handle *handle) {
+    if (self->count == self->capacity) {
+        return NULL;
+    }
+
+    // Slots the pool never handed out before have no generation yet
+    bool fresh = self->slots.head == NULL;
+    Slot_Map_Slot *slot = (Slot_Map_Slot *)pool_alloc(&self->slots);
+    if (fresh) {
+        slot->generation = 1;
+    }
+
+    u32 index = (u32)(slot - (Slot_Map_Slot *)self->slots.data);
+    slot->dense = self->count;
+    self->dense_slots[self->count] = index;
+
+    handle->index = index;
+    handle->generation = slot->generation;
+
+    return self->data + (usize)self->count++ * self->stride;
+}
+
+// Copies 'stride' bytes from 'value', returns a zeroed handle when the map is full
+Slot_Handle slot_map_insert(Slot_Map *self, const void *value) {
+    Slot_Handle handle = {0, 0};
+
+    void *mem = slot_map_alloc(self, &handle);
+    if (mem != NULL) {
+        memcpy(mem, value, self->stride);
+    }
+
+    return handle;
+}
+
+// Position of the value in 'data', or -1 if the handle is stale
+isize slot_map_index(Slot_Map *self, Slot_Handle handle) {
+    // Slots past the pool's bump offset were never handed out and hold garbage
+    if ((usize)handle.index * sizeof(Slot_Map_Slot) >= self->slots.bump_offset) {
+        return -1;
+    }
+
+    Slot_Map_Slot *slot = _slot_map_slot(self, handle.index);
+
+    return slot->generation == handle.generation ? (isize)slot->dense : -1;
+}
+
+void *slot_map_get(Slot_Map *self, Slot_Handle handle) {
+    isize i = slot_map_index(self, handle);
+
+    return i >= 0 ? self->data + (usize)i * self->stride : NULL;
+}
+
+bool slot_map_has(Slot_Map *self, Slot_Handle handle) {
+    return slot_map_index(self, handle) >= 0;
+}
+
+// Handle of the value at position 'i' in 'data', for iterating with handles
+Slot_Handle slot_map_handle(Slot_Map *self, u32 i) {
+    assert(i < self->count);
+
+    Slot_Handle handle;
+    handle.index = self->dense_slots[i];
+    handle.generation = _slot_map_slot(self, handle.index)->generation;
+
+    return handle;
+}
+
+internal void _slot_map_free_slot(Slot_Map *self, Slot_Map_Slot *slot) {
+    // Generation 0 is reserved for invalid handles
+    if (++slot->generation == 0) {
+        slot->generation = 1;
+    }
+
+    pool_free(&self->slots, slot);
+}
+
+// Returns false if the handle was stale already
+bool slot_map_remove(Slot_Map *self, Slot_Handle handle) {
+    isize i = slot_map_index(self, handle);
+    if (i < 0) {
+        return false;
+    }
+
+    u32 last = --self->count;
+
+    // Keep the values packed by moving the last one into the hole
+    if ((u32)i != last) {
+        memcpy(self->data + (usize)i * self->stride, self->data + (usize)last * self->stride, self->stride);
+
+        u32 moved = self->dense_slots[last];
+        self->dense_slots[i] = moved;
+        _slot_map_slot(self, moved)->dense = (u32)i;
+    }
+
+    _slot_map_free_slot(self, _slot_map_slot(self, handle.index));
+
+    return true;
+}
+
+// Removes every value, all handles handed out so far become stale
+void slot_map_clear(Slot_Map *self) {
+    for (u32 i = 0; i < self->count; ++i) {
+        _slot_map_free_slot(self, _slot_map_slot(self, self->dense_slots[i]));
+    }
+
+    self->count = 0;
+}
+
+// --------------------------------------------------------------------------------
+
+#endif // SLOT_MAP_H
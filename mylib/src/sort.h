@@ -0,0 +1,447 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include "core.h"
+#include "job.h"
+
+// --------------------------------------------------------------------------------
+
+// Type-specialized sorting, instantiated per element type so that the comparison is inlined.
+//
+//     #define int_less(a, b) ((a) < (b))
+//     SORT_DEFINE(int, int, int_less)        // int_sort(int *a, usize n)
+//
+//     #define pair_key(x) ((x).key)
+//     RADIX_SORT_DEFINE(pair, Pair, u32, pair_key)  // pair_radix_sort(Pair *a, usize n)
+//
+// 'array_sort' is not affected and still calls 'qsort' with an indirect call per comparison, since
+// it takes an arbitrary comparator. Arrays sort through these with 'array_sort_with' instead, e.g.
+// 'array_sort_with(a, int)' for the instantiation above. The built-in key types below come ready
+// made: 'array_sort_with(a, u32_radix)' radix sorts and 'array_sort_with(a, u32_radix_key)' uses
+// introsort.
+
+#define SORT_INSERTION_CUTOFF  24
+
+#define array_sort_with(a, name)  ((a) ? name##_sort((a), _array_count(a)), (a) : NULL)
+
+// --------------------------------------------------------------------------------
+
+// Introsort: quicksort with a median-of-three pivot, heapsort once recursion gets too deep and
+// insertion sort for short ranges. 'less' is a function or function-like macro taking two elements.
+
+#define SORT_DEFINE(name, T, less) \
+    internal inline void name##_insertion_sort(T *a, usize n) { \
+        for (usize i = 1; i < n; ++i) { \
+            T x = a[i]; \
+            usize j = i; \
+            for (; j > 0 && less(x, a[j - 1]); --j) { \
+                a[j] = a[j - 1]; \
+            } \
+            a[j] = x; \
+        } \
+    } \
+    \
+    internal inline void name##_sift_down(T *a, usize root, usize n) { \
+        T x = a[root]; \
+        for (usize child = 2 * root + 1; child < n; child = 2 * root + 1) { \
+            if (child + 1 < n && less(a[child], a[child + 1])) { \
+                ++child; \
+            } \
+            if (!less(x, a[child])) { \
+                break; \
+            } \
+            a[root] = a[child]; \
+            root = child; \
+        } \
+        a[root] = x; \
+    } \
+    \
+    internal inline void name##_heap_sort(T *a, usize n) { \
+        for (usize i = n / 2; i-- > 0;) { \
+            name##_sift_down(a, i, n); \
+        } \
+        for (usize i = n; i-- > 1;) { \
+            T x = a[0]; a[0] = a[i]; a[i] = x; \
+            name##_sift_down(a, 0, i); \
+        } \
+    } \
+    \
+    internal inline void name##_intro_sort(T *a, usize n, u32 depth) { \
+        while (n > SORT_INSERTION_CUTOFF) { \
+            if (depth-- == 0) { \
+                name##_heap_sort(a, n); \
+                return; \
+            } \
+            /* Order first, middle and last, leaving the median in the middle as a sentinel-backed pivot */ \
+            usize mid = n / 2; \
+            T x; \
+            if (less(a[mid], a[0]))     { x = a[mid]; a[mid] = a[0]; a[0] = x; } \
+            if (less(a[n - 1], a[mid])) { x = a[mid]; a[mid] = a[n - 1]; a[n - 1] = x; } \
+            if (less(a[mid], a[0]))     { x = a[mid]; a[mid] = a[0]; a[0] = x; } \
+            T pivot = a[mid]; \
+            usize i = 0, j = n - 1; \
+            for (;;) { \
+                while (less(a[i], pivot)) ++i; \
+                while (less(pivot, a[j])) --j; \
+                if (i >= j) break; \
+                x = a[i]; a[i] = a[j]; a[j] = x; \
+                ++i, --j; \
+            } \
+            /* Recurse into the smaller half and loop on the larger one to bound stack depth */ \
+            if (j + 1 < n - j - 1) { \
+                name##_intro_sort(a, j + 1, depth); \
+                a += j + 1; \
+                n -= j + 1; \
+            } else { \
+                name##_intro_sort(a + j + 1, n - j - 1, depth); \
+                n = j + 1; \
+            } \
+        } \
+        name##_insertion_sort(a, n); \
+    } \
+    \
+    internal inline void name##_sort(T *a, usize n) { \
+        u32 depth = 0; \
+        for (usize m = n; m > 1; m >>= 1) { \
+            depth += 2; \
+        } \
+        name##_intro_sort(a, n, depth); \
+    }
+
+// --------------------------------------------------------------------------------
+
+// LSD radix sort, one byte per pass. 'key_of' maps an element to an unsigned integer of type K whose
+// order is the desired sort order, which also makes this the key-plus-payload variant when T is a
+// struct. Passes where every key has the same digit are skipped. Scratch memory comes from the
+// calling thread's scratch arenas, so no allocation happens per call. If those can't hold a copy of
+// the array, the elements are sorted by key with introsort instead, which is not stable.
+
+#define RADIX_SORT_DEFINE(name, T, K, key_of) \
+    internal inline bool name##_radix_key_less(T x, T y) { \
+        return (K)key_of(x) < (K)key_of(y); \
+    } \
+    \
+    SORT_DEFINE(name##_radix_key, T, name##_radix_key_less) \
+    \
+    internal inline void name##_radix_sort(T *a, usize n) { \
+        if (n < 2) { \
+            return; \
+        } \
+        if (n <= SORT_INSERTION_CUTOFF) { \
+            name##_radix_key_insertion_sort(a, n); \
+            return; \
+        } \
+        \
+        Tmp_Arena scratch = scratch_begin(NULL, 0); \
+        T *tmp = (T *)arena_alloc(scratch.mem, n * sizeof(T)); \
+        usize *counts = (usize *)arena_alloc(scratch.mem, sizeof(K) * 256 * sizeof(usize)); \
+        \
+        if (tmp == NULL || counts == NULL) { \
+            scratch_end(scratch); \
+            name##_radix_key_sort(a, n); \
+            return; \
+        } \
+        memset(counts, 0, sizeof(K) * 256 * sizeof(usize)); \
+        \
+        /* Histogram every digit in a single pass */ \
+        for (usize i = 0; i < n; ++i) { \
+            K key = (K)key_of(a[i]); \
+            for (usize d = 0; d < sizeof(K); ++d) { \
+                ++counts[d * 256 + ((key >> (d * 8)) & 0xff)]; \
+            } \
+        } \
+        \
+        T *src = a, *dst = tmp; \
+        for (usize d = 0; d < sizeof(K); ++d) { \
+            usize *count = counts + d * 256; \
+            if (count[((K)key_of(src[0]) >> (d * 8)) & 0xff] == n) { \
+                continue; \
+            } \
+            usize offset = 0; \
+            for (usize b = 0; b < 256; ++b) { \
+                usize c = count[b]; \
+                count[b] = offset; \
+                offset += c; \
+            } \
+            for (usize i = 0; i < n; ++i) { \
+                dst[count[((K)key_of(src[i]) >> (d * 8)) & 0xff]++] = src[i]; \
+            } \
+            T *swap = src; src = dst; dst = swap; \
+        } \
+        \
+        if (src != a) { \
+            memcpy(a, src, n * sizeof(T)); \
+        } \
+        \
+        scratch_end(scratch); \
+    }
+
+// --------------------------------------------------------------------------------
+
+// Parallel merge sort on top of a SORT_DEFINE instantiation of the same name, running on a job system
+// so that sorting from inside a job doesn't oversubscribe the cores. Each chunk is sorted as one job,
+// then log2(chunks) rounds merge neighbouring runs. In every round the output is split into equal
+// slices for 'job_parallel_for', each finding where it starts in both input runs by binary search
+// (merge path), so all workers stay busy up to the last merge. The merge buffer comes from 'scratch'.
+//
+//     PARALLEL_SORT_DEFINE(int, int, int_less)  // int_parallel_sort(int *a, usize n, Arena *scratch, Job_System *jobs)
+
+#define PARALLEL_SORT_MIN_SIZE  (1 << 17)
+
+#define PARALLEL_SORT_DEFINE(name, T, less) \
+    /* Number of elements the first 'k' merged outputs take from 'x', ties going to 'x' */ \
+    internal inline usize name##_co_rank(usize k, T *x, usize nx, T *y, usize ny) { \
+        usize lo = k > ny ? k - ny : 0, hi = k < nx ? k : nx; \
+        while (lo < hi) { \
+            usize i = lo + (hi - lo) / 2, j = k - i; \
+            if (j > 0 && i < nx && !less(y[j - 1], x[i])) { \
+                lo = i + 1; \
+            } else { \
+                hi = i; \
+            } \
+        } \
+        return lo; \
+    } \
+    \
+    /* Writes the slice [lo, hi) of the output of merging neighbouring runs of 'w' elements from 'src' into 'dst' */ \
+    internal inline void name##_merge_slice(T *src, T *dst, usize n, usize w, usize lo, usize hi) { \
+        for (usize s = lo / (2 * w) * (2 * w); s < hi; s += 2 * w) { \
+            usize mid = s + w < n ? s + w : n, stop = s + 2 * w < n ? s + 2 * w : n; \
+            usize k0 = (lo > s ? lo : s) - s, k1 = (hi < stop ? hi : stop) - s; \
+            T *x = src + s, *y = src + mid; \
+            usize nx = mid - s, ny = stop - mid; \
+            usize i = name##_co_rank(k0, x, nx, y, ny), j = k0 - i; \
+            usize i1 = name##_co_rank(k1, x, nx, y, ny), j1 = k1 - i1; \
+            T *out = dst + s + k0; \
+            while (i < i1 && j < j1) { \
+                *out++ = less(y[j], x[i]) ? y[j++] : x[i++]; \
+            } \
+            while (i < i1) *out++ = x[i++]; \
+            while (j < j1) *out++ = y[j++]; \
+        } \
+    } \
+    \
+    typedef struct _##name##_Sort_Job { \
+        T    *a, *src, *dst; \
+        usize n, chunk, w; \
+    } name##_Sort_Job; \
+    \
+    internal inline void name##_sort_chunks(void *data, usize begin, usize end, Arena *scratch) { \
+        name##_Sort_Job *job = (name##_Sort_Job *)data; \
+        (void)scratch; \
+        for (usize c = begin; c < end; ++c) { \
+            usize lo = c * job->chunk, hi = lo + job->chunk < job->n ? lo + job->chunk : job->n; \
+            name##_sort(job->a + lo, hi - lo); \
+        } \
+    } \
+    \
+    internal inline void name##_sort_merge(void *data, usize begin, usize end, Arena *scratch) { \
+        name##_Sort_Job *job = (name##_Sort_Job *)data; \
+        (void)scratch; \
+        name##_merge_slice(job->src, job->dst, job->n, job->w, begin, end); \
+    } \
+    \
+    internal inline void name##_sort_copy(void *data, usize begin, usize end, Arena *scratch) { \
+        name##_Sort_Job *job = (name##_Sort_Job *)data; \
+        (void)scratch; \
+        memcpy(job->a + begin, job->src + begin, (end - begin) * sizeof(T)); \
+    } \
+    \
+    /* One chunk per worker, falling back to the serial sort for short arrays or without a merge buffer */ \
+    internal inline void name##_parallel_sort(T *a, usize n, Arena *scratch, Job_System *jobs) { \
+        usize num_chunks = jobs->num_workers; \
+        while (num_chunks > 1 && n / num_chunks < PARALLEL_SORT_MIN_SIZE / 2) { \
+            --num_chunks; \
+        } \
+        \
+        Tmp_Arena tmp_mem = tmp_arena_begin(scratch); \
+        T *tmp = num_chunks > 1 ? (T *)arena_alloc(scratch, n * sizeof(T)) : NULL; \
+        \
+        if (n < PARALLEL_SORT_MIN_SIZE || tmp == NULL) { \
+            name##_sort(a, n); \
+            tmp_arena_end(tmp_mem); \
+            return; \
+        } \
+        \
+        name##_Sort_Job job = {a, a, tmp, n, (n + num_chunks - 1) / num_chunks, 0}; \
+        job_parallel_for(jobs, num_chunks, 1, name##_sort_chunks, &job); \
+        \
+        for (job.w = job.chunk; job.w < n; job.w *= 2) { \
+            job_parallel_for(jobs, n, job.chunk, name##_sort_merge, &job); \
+            T *swap = job.src; job.src = job.dst; job.dst = swap; \
+        } \
+        \
+        if (job.src != a) { \
+            job_parallel_for(jobs, n, job.chunk, name##_sort_copy, &job); \
+        } \
+        \
+        tmp_arena_end(tmp_mem); \
+    }
+
+// --------------------------------------------------------------------------------
+
+// Order-preserving maps from signed and floating-point keys to unsigned ones
+internal inline u32 sort_key_i32(i32 x) { return (u32)x ^ 0x80000000u; }
+internal inline u64 sort_key_i64(i64 x) { return (u64)x ^ 0x8000000000000000ull; }
+
+internal inline u32 sort_key_f32(f32 x) {
+    u32 bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    // Negative numbers sort in reverse, so flip all their bits; positive ones just move above them
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+internal inline u64 sort_key_f64(f64 x) {
+    u64 bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+#define _sort_identity(x)  (x)
+#define _sort_kv_key(x)    ((x).key)
+
+RADIX_SORT_DEFINE(u32, u32, u32, _sort_identity)
+RADIX_SORT_DEFINE(u64, u64, u64, _sort_identity)
+RADIX_SORT_DEFINE(i32, i32, u32, sort_key_i32)
+RADIX_SORT_DEFINE(i64, i64, u64, sort_key_i64)
+RADIX_SORT_DEFINE(f32, f32, u32, sort_key_f32)
+RADIX_SORT_DEFINE(f64, f64, u64, sort_key_f64)
+
+// --------------------------------------------------------------------------------
+
+typedef struct _Sort_Kv32 {
+    u32 key, value;
+} Sort_Kv32;
+
+typedef struct _Sort_Kv64 {
+    u64 key, value;
+} Sort_Kv64;
+
+RADIX_SORT_DEFINE(kv32, Sort_Kv32, u32, _sort_kv_key)
+RADIX_SORT_DEFINE(kv64, Sort_Kv64, u64, _sort_kv_key)
+
+// --------------------------------------------------------------------------------
+
+#if defined(__cplusplus) && (__cplusplus >= 201103L)
+
+template<typename T> struct Sort_Less {
+    bool operator()(const T &a, const T &b) const { return a < b; }
+};
+
+template<typename T, typename Less>
+internal void insertion_sort(T *a, usize n, Less less) {
+    for (usize i = 1; i < n; ++i) {
+        T x = move(a[i]);
+        usize j = i;
+
+        for (; j > 0 && less(x, a[j - 1]); --j) {
+            a[j] = move(a[j - 1]);
+        }
+
+        a[j] = move(x);
+    }
+}
+
+template<typename T, typename Less>
+internal void _sift_down(T *a, usize root, usize n, Less less) {
+    T x = move(a[root]);
+
+    for (usize child = 2 * root + 1; child < n; child = 2 * root + 1) {
+        if (child + 1 < n && less(a[child], a[child + 1])) {
+            ++child;
+        }
+
+        if (!less(x, a[child])) {
+            break;
+        }
+
+        a[root] = move(a[child]);
+        root = child;
+    }
+
+    a[root] = move(x);
+}
+
+template<typename T>
+inline void _sort_swap(T &a, T &b) {
+    T x = move(a);
+    a = move(b);
+    b = move(x);
+}
+
+template<typename T, typename Less>
+internal void heap_sort(T *a, usize n, Less less) {
+    for (usize i = n / 2; i-- > 0;) {
+        _sift_down(a, i, n, less);
+    }
+
+    for (usize i = n; i-- > 1;) {
+        _sort_swap(a[0], a[i]);
+        _sift_down(a, 0, i, less);
+    }
+}
+
+template<typename T, typename Less>
+internal void _intro_sort(T *a, usize n, u32 depth, Less less) {
+    while (n > SORT_INSERTION_CUTOFF) {
+        if (depth-- == 0) {
+            heap_sort(a, n, less);
+            return;
+        }
+
+        usize mid = n / 2;
+        if (less(a[mid], a[0]))     _sort_swap(a[mid], a[0]);
+        if (less(a[n - 1], a[mid])) _sort_swap(a[mid], a[n - 1]);
+        if (less(a[mid], a[0]))     _sort_swap(a[mid], a[0]);
+
+        T pivot = a[mid];
+        usize i = 0, j = n - 1;
+
+        for (;;) {
+            while (less(a[i], pivot)) ++i;
+            while (less(pivot, a[j])) --j;
+            if (i >= j) break;
+
+            _sort_swap(a[i], a[j]);
+            ++i, --j;
+        }
+
+        if (j + 1 < n - j - 1) {
+            _intro_sort(a, j + 1, depth, less);
+            a += j + 1;
+            n -= j + 1;
+        } else {
+            _intro_sort(a + j + 1, n - j - 1, depth, less);
+            n = j + 1;
+        }
+    }
+
+    insertion_sort(a, n, less);
+}
+
+template<typename T, typename Less = Sort_Less<T>>
+internal void sort(T *a, usize n, Less less = Less()) {
+    u32 depth = 0;
+    for (usize m = n; m > 1; m >>= 1) {
+        depth += 2;
+    }
+
+    _intro_sort(a, n, depth, less);
+}
+
+inline void radix_sort(u32 *a, usize n)       { u32_radix_sort(a, n); }
+inline void radix_sort(u64 *a, usize n)       { u64_radix_sort(a, n); }
+inline void radix_sort(i32 *a, usize n)       { i32_radix_sort(a, n); }
+inline void radix_sort(i64 *a, usize n)       { i64_radix_sort(a, n); }
+inline void radix_sort(f32 *a, usize n)       { f32_radix_sort(a, n); }
+inline void radix_sort(f64 *a, usize n)       { f64_radix_sort(a, n); }
+inline void radix_sort(Sort_Kv32 *a, usize n) { kv32_radix_sort(a, n); }
+inline void radix_sort(Sort_Kv64 *a, usize n) { kv64_radix_sort(a, n); }
+
+#endif // defined(__cplusplus) && (__cplusplus >= 201103L)
+
+// --------------------------------------------------------------------------------
+
+#endif // SORT_H
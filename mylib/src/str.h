@@ -0,0 +1,547 @@
+#ifndef STR_H
+#define STR_H
+
+#include "core.h"
+#include "hash.h"
+
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif // defined(__SSE2__)
+
+// --------------------------------------------------------------------------------
+
+// Non-owning string views. A 'String' is a pointer and a length into memory owned by something else
+// (a file buffer, an arena, a literal), so slicing, splitting and trimming never copy or allocate.
+// The bytes are not NUL-terminated in general, print them with "%.*s" and 'string_fmt'.
+//
+//     i64 size;
+//     char *text = file_read("config.ini", &size, &arena);
+//     String rest = string_make(text, size), line;
+//     while (string_split_next(&rest, '\n', &line)) {
+//         line = string_trim(line);
+//         ...
+//     }
+//
+// Searching and comparing look at 16 bytes at a time with SSE2, and fall back to plain loops elsewhere.
+
+typedef struct _String {
+    const char *data;
+    usize       count;
+} String;
+
+#define string_lit(s)  string_make((s), sizeof(s) - 1)
+#define string_fmt(s)  (int)(s).count, (s).data
+
+String string_make(const char *data, usize count) {
+    String s;
+    s.data = data;
+    s.count = count;
+
+    return s;
+}
+
+String string_from_cstr(const char *cstr) {
+    return string_make(cstr, cstr ? strlen(cstr) : 0);
+}
+
+// Both ends are clamped to the string
+String string_slice(String s, usize begin, usize end) {
+    end = end < s.count ? end : s.count;
+    begin = begin < end ? begin : end;
+
+    return string_make(s.data + begin, end - begin);
+}
+
+// NUL-terminated copy for APIs that want one
+char *string_to_cstr(String s, Arena *arena) {
+    char *cstr = (char *)arena_alloc_align(arena, s.count + 1, 1);
+    if (cstr == NULL) {
+        return NULL;
+    }
+
+    memcpy(cstr, s.data, s.count);
+    cstr[s.count] = '\0';
+
+    return cstr;
+}
+
+u64 string_hash(String s) {
+    return hash_bytes(s.data, s.count);
+}
+
+// --------------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+// One bit for each of the 16 bytes at 'p' that is equal to the byte broadcast in 'c'
+internal u32 _string_match(const char *p, __m128i c) {
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), c));
+}
+
+// One bit for each of the 16 bytes at 'p' that is whitespace
+internal u32 _string_match_space(const char *p) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    // '\t' to '\r' are 9 to 13, bytes above 127 compare as negative and fall outside
+    __m128i ctrl = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(8)), _mm_cmplt_epi8(v, _mm_set1_epi8(14)));
+
+    return (u32)_mm_movemask_epi8(_mm_or_si128(space, ctrl));
+}
+
+#endif // defined(__SSE2__)
+
+internal bool _string_is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Index of the first byte where 'a' and 'b' differ, or 'n' if they are the same
+internal usize _string_mismatch(const char *a, const char *b, usize n) {
+    usize i = 0;
+
+#if defined(__SSE2__)
+    if (n >= 16) {
+        for (; i + 16 <= n; i += 16) {
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+            u32 mask = (u32)_mm_movemask_epi8(eq) ^ 0xFFFF;
+
+            if (mask) {
+                return i + (usize)__builtin_ctz(mask);
+            }
+        }
+
+        // The last partial chunk overlaps the previous one, the bytes already compared are shifted out
+        if (i < n) {
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + n - 16)), _mm_loadu_si128((const __m128i *)(b + n - 16)));
+            u32 mask = ((u32)_mm_movemask_epi8(eq) ^ 0xFFFF) >> (i - (n - 16));
+
+            if (mask) {
+                return i + (usize)__builtin_ctz(mask);
+            }
+        }
+
+        return n;
+    }
+#endif // defined(__SSE2__)
+
+    for (; i + 8 <= n; i += 8) {
+        u64 x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+
+        if (x != y) {
+            break;
+        }
+    }
+
+    for (; i < n; ++i) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+
+    return n;
+}
+
+// --------------------------------------------------------------------------------
+
+bool string_equal(String a, String b) {
+    return a.count == b.count && (a.data == b.data || _string_mismatch(a.data, b.data, a.count) == a.count);
+}
+
+// Bytewise ordering like 'strcmp', a prefix sorts before the longer string
+int string_compare(String a, String b) {
+    usize n = a.count < b.count ? a.count : b.count;
+    usize i = _string_mismatch(a.data, b.data, n);
+
+    if (i < n) {
+        return (int)(ubyte)a.data[i] - (int)(ubyte)b.data[i];
+    }
+
+    return (a.count > b.count) - (a.count < b.count);
+}
+
+bool string_starts_with(String s, String prefix) {
+    return prefix.count <= s.count && _string_mismatch(s.data, prefix.data, prefix.count) == prefix.count;
+}
+
+bool string_ends_with(String s, String suffix) {
+    return suffix.count <= s.count && _string_mismatch(s.data + s.count - suffix.count, suffix.data, suffix.count) == suffix.count;
+}
+
+// --------------------------------------------------------------------------------
+
+// Index of the first 'c' in 's', or -1
+isize string_find_byte(String s, char c) {
+    const char *p = s.data;
+    usize n = s.count, i = 0;
+
+#if defined(__SSE2__)
+    if (n >= 16) {
+        __m128i v = _mm_set1_epi8(c);
+
+        // Long scans test 64 bytes with a single branch and only look for the exact position once
+        // something matched
+        for (; i + 64 <= n; i += 64) {
+            __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), v);
+            __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i + 16)), v);
+            __m128i d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i + 32)), v);
+            __m128i e = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i + 48)), v);
+
+            if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(d, e)))) {
+                break;
+            }
+        }
+
+        for (; i + 16 <= n; i += 16) {
+            u32 mask = _string_match(p + i, v);
+
+            if (mask) {
+                return (isize)(i + (usize)__builtin_ctz(mask));
+            }
+        }
+
+        if (i < n) {
+            u32 mask = _string_match(p + n - 16, v) >> (i - (n - 16));
+
+            if (mask) {
+                return (isize)(i + (usize)__builtin_ctz(mask));
+            }
+        }
+
+        return -1;
+    }
+#endif // defined(__SSE2__)
+
+    for (; i < n; ++i) {
+        if (p[i] == c) {
+            return (isize)i;
+        }
+    }
+
+    return -1;
+}
+
+// Index of the last 'c' in 's', or -1
+isize string_find_last_byte(String s, char c) {
+    const char *p = s.data;
+    usize n = s.count;
+
+#if defined(__SSE2__)
+    if (n >= 16) {
+        __m128i v = _mm_set1_epi8(c);
+
+        for (; n >= 16; n -= 16) {
+            u32 mask = _string_match(p + n - 16, v);
+
+            if (mask) {
+                return (isize)(n - 16 + 31 - (usize)__builtin_clz(mask));
+            }
+        }
+
+        if (n > 0) {
+            u32 mask = _string_match(p, v) & ((1u << n) - 1);
+
+            if (mask) {
+                return (isize)(31 - __builtin_clz(mask));
+            }
+        }
+
+        return -1;
+    }
+#endif // defined(__SSE2__)
+
+    while (n > 0) {
+        if (p[--n] == c) {
+            return (isize)n;
+        }
+    }
+
+    return -1;
+}
+
+// Index of the first occurrence of 'needle' in 's', or -1. An empty needle is found at 0.
+
+// Adapted from http://0x80.pl/articles/simd-strfind.html
+isize string_find(String s, String needle) {
+    const char *p = s.data;
+    usize n = s.count, k = needle.count;
+
+    if (k == 0) {
+        return 0;
+    }
+    if (k > n) {
+        return -1;
+    }
+    if (k == 1) {
+        return string_find_byte(s, needle.data[0]);
+    }
+
+    char first = needle.data[0], last = needle.data[k - 1];
+    // Last position the needle can start at
+    usize end = n - k;
+    usize i = 0;
+
+#if defined(__SSE2__)
+    // Checks 16 positions at once for both the first and the last byte of the needle, and only
+    // compares the middle where both match
+    __m128i vfirst = _mm_set1_epi8(first), vlast = _mm_set1_epi8(last);
+
+    for (; i + 15 <= end; i += 16) {
+        u32 mask = _string_match(p + i, vfirst) & _string_match(p + i + k - 1, vlast);
+
+        while (mask) {
+            usize j = i + (usize)__builtin_ctz(mask);
+
+            if (memcmp(p + j + 1, needle.data + 1, k - 2) == 0) {
+                return (isize)j;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+#endif // defined(__SSE2__)
+
+    for (; i <= end; ++i) {
+        if (p[i] == first && p[i + k - 1] == last && memcmp(p + i + 1, needle.data + 1, k - 2) == 0) {
+            return (isize)i;
+        }
+    }
+
+    return -1;
+}
+
+// --------------------------------------------------------------------------------
+
+// Whitespace is ' ', '\t', '\n', '\v', '\f' and '\r'
+
+String string_trim_left(String s) {
+    usize i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= s.count; i += 16) {
+        u32 mask = _string_match_space(s.data + i) ^ 0xFFFF;
+
+        if (mask) {
+            i += (usize)__builtin_ctz(mask);
+
+            return string_make(s.data + i, s.count - i);
+        }
+    }
+#endif // defined(__SSE2__)
+
+    while (i < s.count && _string_is_space(s.data[i])) {
+        ++i;
+    }
+
+    return string_make(s.data + i, s.count - i);
+}
+
+String string_trim_right(String s) {
+    usize n = s.count;
+
+#if defined(__SSE2__)
+    for (; n >= 16; n -= 16) {
+        u32 mask = _string_match_space(s.data + n - 16) ^ 0xFFFF;
+
+        if (mask) {
+            return string_make(s.data, n - 16 + 32 - (usize)__builtin_clz(mask));
+        }
+    }
+#endif // defined(__SSE2__)
+
+    while (n > 0 && _string_is_space(s.data[n - 1])) {
+        --n;
+    }
+
+    return string_make(s.data, n);
+}
+
+String string_trim(String s) {
+    return string_trim_right(string_trim_left(s));
+}
+
+// --------------------------------------------------------------------------------
+
+// Pops the next 'sep'-separated token off the front of 'rest', returning false once nothing is left.
+// Empty tokens between two separators are kept, but a separator at the very end doesn't produce an
+// empty last token, so the lines of a file ending with '\n' come out as expected.
+bool string_split_next(String *rest, char sep, String *token) {
+    if (rest->count == 0) {
+        return false;
+    }
+
+    isize i = string_find_byte(*rest, sep);
+
+    if (i < 0) {
+        *token = *rest;
+        rest->data += rest->count;
+        rest->count = 0;
+    } else {
+        *token = string_make(rest->data, (usize)i);
+        rest->data += i + 1;
+        rest->count -= (usize)i + 1;
+    }
+
+    return true;
+}
+
+// All the tokens of 'string_split_next' in an array, they still point into 's'. NULL if the array
+// couldn't grow.
+String *string_split(String s, char sep, Allocator allocator) {
+    String *tokens = NULL;
+    array_init(tokens, allocator, 16);
+
+    String token;
+    while (tokens && string_split_next(&s, sep, &token)) {
+        array_push(tokens, token);
+    }
+
+    return tokens;
+}
+
+// --------------------------------------------------------------------------------
+
+// Builds a string at the top of an arena. As long as nothing else is allocated from the arena in
+// between, every append grows the same allocation in place (see 'arena_resize_align'), so the text
+// is never copied. Otherwise it moves once to the new top of the arena and keeps growing from there.
+// The text is always NUL-terminated.
+//
+//     String_Builder sb;
+//     string_builder_init(&sb, &arena);
+//     string_builder_appendf(&sb, "%s=%d", name, value);
+//     String s = string_builder_end(&sb);
+
+#define STRING_BUILDER_MIN_CAPACITY  64
+
+typedef struct _String_Builder {
+    Arena *arena;
+    char  *data;
+    usize  count, capacity;
+} String_Builder;
+
+void string_builder_init(String_Builder *self, Arena *arena) {
+    assert(arena != NULL);
+
+    self->arena = arena;
+    self->data = NULL;
+    self->count = 0;
+    self->capacity = 0;
+}
+
+// Makes room for 'size' more bytes and the NUL
+internal bool _string_builder_grow(String_Builder *self, usize size) {
+    usize needed = self->count + size + 1;
+    if (needed <= self->capacity) {
+        return true;
+    }
+
+    usize capacity = self->capacity ? self->capacity : STRING_BUILDER_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    char *data = (char *)arena_resize_align(self->arena, self->data, self->capacity, capacity, 1);
+    if (data == NULL) {
+        return false;
+    }
+
+    self->data = data;
+    self->capacity = capacity;
+
+    return true;
+}
+
+bool string_builder_append(String_Builder *self, String s) {
+    if (!_string_builder_grow(self, s.count)) {
+        return false;
+    }
+
+    memcpy(self->data + self->count, s.data, s.count);
+    self->count += s.count;
+    self->data[self->count] = '\0';
+
+    return true;
+}
+
+bool string_builder_append_cstr(String_Builder *self, const char *cstr) {
+    return string_builder_append(self, string_from_cstr(cstr));
+}
+
+bool string_builder_append_byte(String_Builder *self, char c) {
+    if (!_string_builder_grow(self, 1)) {
+        return false;
+    }
+
+    self->data[self->count++] = c;
+    self->data[self->count] = '\0';
+
+    return true;
+}
+
+// Formats straight into the arena, only formatting a second time when the text didn't fit
+bool string_builder_appendf(String_Builder *self, const char *fmt, ...) {
+    if (!_string_builder_grow(self, 0)) {
+        return false;
+    }
+
+    va_list args, retry;
+    va_start(args, fmt);
+    va_copy(retry, args);
+
+    usize room = self->capacity - self->count;
+    int n = vsnprintf(self->data + self->count, room, fmt, args);
+    va_end(args);
+
+    bool ok = n >= 0;
+    if (ok && (usize)n >= room) {
+        ok = _string_builder_grow(self, (usize)n);
+
+        if (ok) {
+            vsnprintf(self->data + self->count, (usize)n + 1, fmt, retry);
+        }
+    }
+
+    va_end(retry);
+
+    if (!ok) {
+        // Drop whatever part of the text was written
+        self->data[self->count] = '\0';
+        return false;
+    }
+
+    self->count += (usize)n;
+
+    return true;
+}
+
+// View of the text so far, it moves if the builder has to leave its place in the arena
+String string_builder_to_string(String_Builder *self) {
+    return string_make(self->data, self->count);
+}
+
+// Returns the finished string and gives the unused capacity back to the arena when the string is
+// still its last allocation. The builder starts over empty.
+String string_builder_end(String_Builder *self) {
+    String s = string_builder_to_string(self);
+    Arena *arena = self->arena;
+
+    if (self->data && arena->data + arena->prev_offset == (ubyte *)self->data) {
+        arena_resize_align(arena, self->data, self->capacity, self->count + 1, 1);
+    }
+
+    string_builder_init(self, arena);
+
+    return s;
+}
+
+void string_builder_clear(String_Builder *self) {
+    self->count = 0;
+
+    if (self->data) {
+        self->data[0] = '\0';
+    }
+}
+
+// --------------------------------------------------------------------------------
+
+#endif // STR_H
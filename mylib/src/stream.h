@@ -0,0 +1,263 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "core.h"
+
+#include <pthread.h>
+#include <errno.h>
+
+// --------------------------------------------------------------------------------
+
+// Streaming file reader for files of any size in constant memory. The file is read in fixed-size
+// chunks into buffers taken once from an arena, with 64-bit offsets throughout. With read-ahead on,
+// a background thread fills the next chunk while the caller works on the current one, so parsing
+// and disk reads overlap.
+//
+//     File_Stream stream;
+//     if (file_stream_open(&stream, "huge.log", MB(4), true, &arena)) {
+//         File_Chunk chunk;
+//         while (file_stream_next_chunk(&stream, &chunk)) {
+//             process(chunk.data, chunk.count);       // Valid until the next call
+//         }
+//         file_stream_close(&stream);
+//     }
+//
+// Chunks are cut at fixed offsets, so records can straddle two of them; carry the unfinished tail
+// over yourself. 'error' tells a failed read apart from the end of the file.
+
+#define FILE_STREAM_DEFAULT_CHUNK_SIZE  MB(4)
+// Buffers are page aligned, as the kernel copies whole pages fastest
+#define FILE_STREAM_ALIGNMENT           4096
+
+typedef struct _File_Chunk {
+    const char *data;
+    usize       count;
+    // Where 'data' starts in the file
+    u64         offset;
+} File_Chunk;
+
+typedef struct _File_Stream {
+    int             fd;
+    // At open, the stream reads on until the actual end of the file
+    u64             size;
+    usize           chunk_size;
+
+    char           *buffers[2];
+    usize           counts[2];
+    u64             offsets[2];
+    // Holds a chunk the consumer hasn't given back yet
+    bool            full[2];
+
+    // Next file offset to read and next buffer for the consumer
+    u64             read_offset;
+    u32             next;
+    // The consumer still holds the chunk of the other buffer
+    bool            holding;
+    // The reader found the end of the file (or failed), nothing more gets filled
+    bool            done;
+    bool            error;
+
+    bool            read_ahead;
+    bool            quit;
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+} File_Stream;
+
+// Reads up to 'count' bytes at 'offset', retrying short reads. Returns -1 on errors.
+internal isize _file_stream_read(int fd, char *buffer, usize count, u64 offset) {
+    usize total = 0;
+
+    while (total < count) {
+        isize n = pread(fd, buffer + total, count - total, (off_t)(offset + total));
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        total += (usize)n;
+    }
+
+    return (isize)total;
+}
+
+internal void *_file_stream_reader_main(void *arg) {
+    File_Stream *self = (File_Stream *)arg;
+    u32 b = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&self->lock);
+        while (self->full[b] && !self->quit) {
+            pthread_cond_wait(&self->cond, &self->lock);
+        }
+        bool quit = self->quit;
+        pthread_mutex_unlock(&self->lock);
+
+        if (quit) {
+            break;
+        }
+
+        // The consumer gave this buffer back, so it is ours until marked full again
+        u64 offset = self->read_offset;
+        isize n = _file_stream_read(self->fd, self->buffers[b], self->chunk_size, offset);
+
+        pthread_mutex_lock(&self->lock);
+        if (n > 0) {
+            self->counts[b] = (usize)n;
+            self->offsets[b] = offset;
+            self->full[b] = true;
+            self->read_offset = offset + (u64)n;
+        }
+
+        // A short chunk is the last one
+        bool last = n < (isize)self->chunk_size;
+        self->error = n < 0;
+        self->done = last;
+
+        pthread_cond_broadcast(&self->cond);
+        pthread_mutex_unlock(&self->lock);
+
+        if (last) {
+            break;
+        }
+
+        b ^= 1;
+    }
+
+    return NULL;
+}
+
+// Opens 'path' for streaming in chunks of 'chunk_size' bytes (the default when 0), with two buffers
+// from 'arena' when 'read_ahead' is on and one otherwise
+bool file_stream_open(File_Stream *self, const char *path, usize chunk_size, bool read_ahead, Arena *arena) {
+    assert(path != NULL);
+    assert(arena != NULL);
+
+    memset(self, 0, sizeof(*self));
+
+    self->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (self->fd < 0) {
+        return false;
+    }
+
+    struct stat s;
+    if (fstat(self->fd, &s) != 0) {
+        close(self->fd);
+        return false;
+    }
+
+    self->size = (u64)s.st_size;
+    self->chunk_size = chunk_size ? chunk_size : FILE_STREAM_DEFAULT_CHUNK_SIZE;
+    self->read_ahead = read_ahead;
+
+    for (u32 i = 0; i < (read_ahead ? 2u : 1u); ++i) {
+        self->buffers[i] = (char *)arena_alloc_align(arena, self->chunk_size, FILE_STREAM_ALIGNMENT);
+
+        if (self->buffers[i] == NULL) {
+            close(self->fd);
+            return false;
+        }
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(self->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif // POSIX_FADV_SEQUENTIAL
+
+    if (read_ahead) {
+        pthread_mutex_init(&self->lock, NULL);
+        pthread_cond_init(&self->cond, NULL);
+
+        if (pthread_create(&self->thread, NULL, _file_stream_reader_main, self) != 0) {
+            // Reading on the calling thread still works
+            pthread_cond_destroy(&self->cond);
+            pthread_mutex_destroy(&self->lock);
+            self->read_ahead = false;
+        }
+    }
+
+    return true;
+}
+
+// Hands out the next chunk, which stays valid until the next call. Returns false at the end of the
+// file or when a read failed, which sets 'error'.
+bool file_stream_next_chunk(File_Stream *self, File_Chunk *chunk) {
+    assert(chunk != NULL);
+
+    if (!self->read_ahead) {
+        if (self->done) {
+            return false;
+        }
+
+        isize n = _file_stream_read(self->fd, self->buffers[0], self->chunk_size, self->read_offset);
+
+        self->error = n < 0;
+        self->done = n < (isize)self->chunk_size;
+
+        if (n <= 0) {
+            return false;
+        }
+
+        chunk->data = self->buffers[0];
+        chunk->count = (usize)n;
+        chunk->offset = self->read_offset;
+        self->read_offset += (u64)n;
+
+        return true;
+    }
+
+    pthread_mutex_lock(&self->lock);
+
+    // The previous chunk is done with, the reader may fill its buffer again
+    if (self->holding) {
+        self->full[self->next ^ 1] = false;
+        self->holding = false;
+        pthread_cond_broadcast(&self->cond);
+    }
+
+    u32 b = self->next;
+    while (!self->full[b] && !self->done) {
+        pthread_cond_wait(&self->cond, &self->lock);
+    }
+
+    bool ok = self->full[b];
+    if (ok) {
+        chunk->data = self->buffers[b];
+        chunk->count = self->counts[b];
+        chunk->offset = self->offsets[b];
+
+        self->holding = true;
+        self->next = b ^ 1;
+    }
+
+    pthread_mutex_unlock(&self->lock);
+
+    return ok;
+}
+
+// Stops the read-ahead thread and closes the file. The buffers go back with the arena.
+void file_stream_close(File_Stream *self) {
+    if (self->read_ahead) {
+        pthread_mutex_lock(&self->lock);
+        self->quit = true;
+        pthread_cond_broadcast(&self->cond);
+        pthread_mutex_unlock(&self->lock);
+
+        pthread_join(self->thread, NULL);
+
+        pthread_cond_destroy(&self->cond);
+        pthread_mutex_destroy(&self->lock);
+    }
+
+    close(self->fd);
+    self->fd = -1;
+}
+
+// --------------------------------------------------------------------------------
+
+#endif // STREAM_H
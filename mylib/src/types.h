@@ -1,6 +1,11 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+// Must come before any system header so that POSIX/BSD extensions like MAP_ANONYMOUS are visible
+#ifndef _DEFAULT_SOURCE
+#   define _DEFAULT_SOURCE
+#endif // _DEFAULT_SOURCE
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -77,6 +82,12 @@ typedef uintptr_t        uptr;
 #define global           static
 #define internal         static
 
+#if defined(_MSC_VER)
+#   define per_thread    __declspec(thread)
+#else
+#   define per_thread    __thread
+#endif // defined(_MSC_VER)
+
 // --------------------------------------------------------------------------------
 
 #define introspect(args)
@@ -96,5 +96,48 @@ int main(void) {
 
     array_free(arr1);
 
+    ubyte buffer[KB(1)];
+    Arena arena;
+    arena_init(&arena, buffer, sizeof(buffer));
+
+    int *arr3 = NULL;
+    array_init(arr3, arena_allocator(&arena), 2);
+
+    for (int i = 0; i < 10; ++i) {
+        array_push(arr3, i);
+    }
+
+    // Grew in place as it was the arena's last allocation
+    watch(arr3, "push into arena");
+    printf("arena offset: %zu\n\n", arena.cur_offset);
+
+    int *arr4 = NULL;
+    array_copy(arr4, arr3);
+
+    watch(arr4, "copy into arena");
+
+    array_free(arr4);
+    array_free(arr3);
+
+    inline_array(int, 4) storage;
+    int *arr5 = NULL;
+    array_init_inline(arr5, storage, heap_allocator());
+
+    array_push(arr5, 1);
+    array_push(arr5, 2);
+    array_insert(arr5, 0, 0);
+
+    watch(arr5, "push into inline storage");
+    printf("inline: %s\n\n", (void *)arr5 == (void *)storage.elems ? "yes" : "no");
+
+    array_push(arr5, 3);
+    array_push(arr5, 4);
+    array_remove(arr5, 0);
+
+    watch(arr5, "spill to the heap");
+    printf("inline: %s\n\n", (void *)arr5 == (void *)storage.elems ? "yes" : "no");
+
+    array_free(arr5);
+
     return 0;
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "../src/core.h"
+#include "../src/hashmap.h"
 
 #define watch(arr, op) \
     printf("[%s] after %s\n", #arr, (op)); \
@@ -8,6 +8,24 @@
     } \
     printf("\n\n");
 
+struct Tracked {
+    static int copies, moves, alive;
+
+    int value;
+
+    Tracked(int v = 0) : value(v)                      { ++alive; }
+    Tracked(const Tracked &other) : value(other.value) { ++copies; ++alive; }
+    Tracked(Tracked &&other) : value(other.value)      { ++moves; ++alive; }
+    ~Tracked()                                         { --alive; }
+
+    Tracked &operator=(const Tracked &other) { value = other.value; ++copies; return *this; }
+    Tracked &operator=(Tracked &&other)      { value = other.value; ++moves; return *this; }
+};
+
+int Tracked::copies = 0;
+int Tracked::moves = 0;
+int Tracked::alive = 0;
+
 int main(void) {
     int *arr = NULL;
     defer {
@@ -21,5 +39,100 @@ int main(void) {
 
     watch(arr, "push");
 
+    {
+        Array<Tracked> tracked;
+        for (int i = 0; i < 100; ++i) {
+            tracked.emplace(i);
+        }
+
+        tracked.insert(0, Tracked(-1));
+        tracked.remove(50);
+
+        Array<Tracked> other = move(tracked);
+        printf("[tracked] count: %zu first: %d last: %d copies: %d moves: %d\n\n",
+               other.count(), other[0].value, other.last().value, Tracked::copies, Tracked::moves);
+        assert(Tracked::copies == 0);
+    }
+
+    {
+        // Pushing an element of the array itself while growing it
+        Array<Tracked> self_ref;
+        for (int i = 0; i < 4; ++i) {
+            self_ref.emplace(i * 10);
+        }
+
+        assert(self_ref.count() == self_ref.capacity());
+        self_ref.push(self_ref[1]);
+        assert(self_ref.last().value == 10);
+
+        Array<int> ints;
+        ints.push(7);
+        ints.push(8);
+        ints.push(ints[0]);
+        assert(ints.count() == 3 && ints.last() == 7);
+    }
+
+    printf("[tracked] alive after scope: %d\n\n", Tracked::alive);
+    assert(Tracked::alive == 0);
+
+    {
+        Small_Array<Tracked, 4> small;
+        for (int i = 0; i < 3; ++i) {
+            small.emplace(i);
+        }
+
+        Small_Array<Tracked, 4> moved = move(small);
+        printf("[small] count: %zu inline: %d\n", moved.count(), moved.is_inline());
+
+        for (int i = 3; i < 8; ++i) {
+            moved.emplace(i);
+        }
+
+        Small_Array<Tracked, 4> spilled = move(moved);
+        printf("[small] count: %zu inline: %d last: %d\n\n", spilled.count(), spilled.is_inline(), spilled.last().value);
+    }
+
+    assert(Tracked::alive == 0);
+
+    ubyte buffer[KB(4)];
+    Arena arena;
+    arena_init(&arena, buffer, sizeof(buffer));
+
+    {
+        Array<int> ints(arena_allocator(&arena));
+        for (int i = 0; i < 10; ++i) {
+            ints.push(i);
+        }
+
+        // Same layout as the array_* macros
+        watch(ints.data, "push into arena");
+
+        Array<int> copy = ints.clone();
+        copy.insert(0, 42);
+        watch(copy.data, "clone + insert");
+    }
+
+    {
+        Hash_Map<u32, f32> weights(arena_allocator(&arena), 4);
+        for (u32 i = 0; i < 32; ++i) {
+            weights.put(i * 3, (f32)i);
+        }
+
+        weights[1] += 2.0f;
+        weights.remove(9);
+
+        f32 sum = 0.0f;
+        for (const auto &entry : weights) {
+            sum += entry.value;
+        }
+
+        printf("[hash map] count: %zu weights[30]: %.1f weights[1]: %.1f has 9: %d sum: %.1f\n\n",
+               weights.count(), *weights.get(30), *weights.get(1), weights.has(9), sum);
+        assert(weights.count() == 32 && sum == 495.0f);
+
+        Hash_Map<u32, f32> moved = move(weights);
+        assert(weights.data == NULL && moved.get(93) != NULL);
+    }
+
     return 0;
-}
\ No newline at end of file
+}
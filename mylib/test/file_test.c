@@ -0,0 +1,128 @@
+#include "../src/core.h"
+
+#include <stdio.h>
+
+#define TEST_PATH   "/tmp/mylib_file_test.bin"
+#define EMPTY_PATH  "/tmp/mylib_file_test_empty.bin"
+#define COPY_PATH   "/tmp/mylib_file_test_copy.bin"
+
+internal bool same_file(const char *a, const char *b) {
+    File_Map x = file_map(a, FILE_MAP_SEQUENTIAL), y = file_map(b, FILE_MAP_SEQUENTIAL);
+    bool same = x.ok && y.ok && x.size == y.size && (x.size == 0 || memcmp(x.data, y.data, (usize)x.size) == 0);
+
+    file_unmap(x);
+    file_unmap(y);
+
+    return same;
+}
+
+internal void write_test_file(const char *path, usize size) {
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+
+    for (usize i = 0; i < size; ++i) {
+        fputc((int)(i * 31 % 251), file);
+    }
+
+    fclose(file);
+}
+
+int main(void) {
+    puts("-- file test --");
+
+    // Not a multiple of the page size, so the last page is only partly the file
+    usize size = MB(3) + 123;
+    write_test_file(TEST_PATH, size);
+    write_test_file(EMPTY_PATH, 0);
+
+    File_Map map = file_map(TEST_PATH, FILE_MAP_SEQUENTIAL | FILE_MAP_WILLNEED);
+    assert(map.ok && map.size == size);
+
+    for (usize i = 0; i < size; ++i) {
+        assert((ubyte)map.data[i] == i * 31 % 251);
+    }
+
+    // Same bytes as the copying read
+    Arena arena;
+    arena_init_virtual(&arena, GB(1));
+
+    i64 read_size = 0;
+    char *copy = file_read(TEST_PATH, &read_size, &arena);
+    assert(copy != NULL && (usize)read_size == size);
+    assert(memcmp(copy, map.data, size) == 0);
+
+    // A buffer smaller than the file takes what fits and stays terminated
+    char head[100];
+    char *partial = file_read_buffer(TEST_PATH, &read_size, head, sizeof(head));
+    assert(partial == head && read_size == sizeof(head) - 1 && head[sizeof(head) - 1] == '\0');
+    assert(memcmp(head, map.data, sizeof(head) - 1) == 0);
+
+    file_unmap(map);
+    printf("mapped %zu bytes\n", size);
+
+    File_Map random_map = file_map(TEST_PATH, FILE_MAP_RANDOM);
+    assert(random_map.ok && (ubyte)random_map.data[size - 1] == (size - 1) * 31 % 251);
+    file_unmap(random_map);
+
+    File_Map empty = file_map(EMPTY_PATH, FILE_MAP_NORMAL);
+    assert(empty.ok && empty.data == NULL && empty.size == 0);
+    file_unmap(empty);
+
+    File_Map missing = file_map("/tmp/mylib_file_test_missing.bin", FILE_MAP_NORMAL);
+    assert(!missing.ok && missing.data == NULL);
+    puts("empty and missing files");
+
+    // Copies, over a larger file that must be truncated
+    write_test_file(COPY_PATH, size * 2);
+    usize arena_offset = arena.cur_offset;
+    bool ok = file_copy(TEST_PATH, COPY_PATH, &arena);
+    assert(ok);
+    assert(same_file(TEST_PATH, COPY_PATH));
+    assert(arena.cur_offset == arena_offset);
+
+    ok = file_copy_allocator(EMPTY_PATH, COPY_PATH, heap_allocator());
+    assert(ok);
+    assert(file_size(COPY_PATH) == 0);
+
+    char small[1000];
+    ok = file_copy_buffer(TEST_PATH, COPY_PATH, small, sizeof(small));
+    assert(ok);
+    assert(same_file(TEST_PATH, COPY_PATH));
+
+    ok = file_copy(EMPTY_PATH ".missing", COPY_PATH, &arena);
+    assert(!ok);
+
+    // The user-space fallback on its own, picking up halfway through
+    int in = open(TEST_PATH, O_RDONLY), out = open(COPY_PATH, O_WRONLY | O_TRUNC);
+    u64 offset = 0;
+    ok = _file_copy_kernel(in, out, &offset, size / 2);
+    assert(ok && offset == size);
+    int truncated = ftruncate(out, (off_t)(size / 2));
+    assert(truncated == 0);
+    ok = _file_copy_chunked(in, out, size / 2, small, sizeof(small));
+    assert(ok);
+    close(in);
+    close(out);
+    assert(same_file(TEST_PATH, COPY_PATH));
+
+    // Claims to be empty, yet has contents
+    ok = file_copy("/proc/self/status", COPY_PATH, &arena);
+    assert(ok);
+    assert(file_size(COPY_PATH) > 0);
+    puts("copies");
+
+    // file_write replaces the contents
+    char text[] = "hello";
+    ok = file_write(COPY_PATH, text, 5);
+    assert(ok);
+    assert(file_size(COPY_PATH) == 5);
+
+    remove(TEST_PATH);
+    remove(EMPTY_PATH);
+    remove(COPY_PATH);
+    arena_release(&arena);
+
+    puts("");
+
+    return 0;
+}
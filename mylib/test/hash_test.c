@@ -0,0 +1,222 @@
+#include "../src/core.h"
+#include "../src/hash.h"
+
+#include <stdio.h>
+
+internal u64 rng_state = 0x9e3779b97f4a7c15ull;
+
+internal u64 rng(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+
+    return rng_state * 2685821657736338717ull;
+}
+
+internal u64 hash_u64_key(const void *key, usize size, u64 seed) {
+    u64 x;
+    assert(size == 8);
+    memcpy(&x, key, 8);
+
+    return hash_u64_seed(x, seed);
+}
+
+typedef u64 (*Hash_Proc)(const void *key, usize size, u64 seed);
+
+// SMHasher-style avalanche: flipping any input bit must flip every output bit half of the time.
+// Returns the worst deviation from 0.5 over all input/output bit pairs.
+internal f64 avalanche(Hash_Proc proc, usize size, usize samples) {
+    local u32 flips[256 * 8][64];
+    memset(flips, 0, sizeof(flips));
+
+    ubyte key[256];
+    assert(size <= sizeof(key));
+
+    for (usize s = 0; s < samples; ++s) {
+        for (usize i = 0; i < size; ++i) {
+            key[i] = (ubyte)rng();
+        }
+
+        u64 h = proc(key, size, 0);
+
+        for (usize bit = 0; bit < size * 8; ++bit) {
+            key[bit / 8] ^= (ubyte)(1 << (bit % 8));
+            u64 d = h ^ proc(key, size, 0);
+            key[bit / 8] ^= (ubyte)(1 << (bit % 8));
+
+            for (u32 out = 0; out < 64; ++out) {
+                flips[bit][out] += (u32)((d >> out) & 1);
+            }
+        }
+    }
+
+    f64 worst = 0.0;
+    for (usize bit = 0; bit < size * 8; ++bit) {
+        for (u32 out = 0; out < 64; ++out) {
+            f64 bias = (f64)flips[bit][out] / (f64)samples - 0.5;
+            bias = bias < 0.0 ? -bias : bias;
+            worst = bias > worst ? bias : worst;
+        }
+    }
+
+    return worst;
+}
+
+#define NUM_KEYS     (1 << 20)
+#define NUM_BUCKETS  (1 << 16)
+
+global u64 hashes[NUM_KEYS];
+global u32 buckets[NUM_BUCKETS];
+
+internal int u64_cmp(const void *a, const void *b) {
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Counts full 64-bit collisions, and measures how evenly the low and high 16 bits spread the keys
+// through a chi-square statistic normalized so that a uniform distribution gives about 1.0
+internal void distribution(const char *name, usize count, usize *collisions, f64 *low, f64 *high) {
+    f64 expected = (f64)count / NUM_BUCKETS;
+
+    for (u32 shift = 0; shift <= 48; shift += 48) {
+        memset(buckets, 0, sizeof(buckets));
+        for (usize i = 0; i < count; ++i) {
+            ++buckets[(hashes[i] >> shift) & (NUM_BUCKETS - 1)];
+        }
+
+        f64 chi = 0.0;
+        for (usize b = 0; b < NUM_BUCKETS; ++b) {
+            chi += ((f64)buckets[b] - expected) * ((f64)buckets[b] - expected) / expected;
+        }
+
+        *(shift == 0 ? low : high) = chi / (NUM_BUCKETS - 1);
+    }
+
+    qsort(hashes, count, sizeof(u64), u64_cmp);
+
+    *collisions = 0;
+    for (usize i = 1; i < count; ++i) {
+        *collisions += hashes[i] == hashes[i - 1];
+    }
+
+    printf("%-22s %zu collisions, chi2 low %.3f high %.3f\n", name, *collisions, *low, *high);
+}
+
+internal void check_distribution(const char *name, usize count) {
+    usize collisions;
+    f64 low, high;
+    distribution(name, count, &collisions, &low, &high);
+
+    assert(collisions == 0);
+    assert(low > 0.95 && low < 1.05);
+    assert(high > 0.95 && high < 1.05);
+}
+
+int main(void) {
+    puts("-- hash test --");
+
+    // Streaming must match the one-shot hash however the input is split
+    local ubyte data[1024];
+    for (usize i = 0; i < sizeof(data); ++i) {
+        data[i] = (ubyte)rng();
+    }
+
+    usize steps[] = {1, 3, 15, 16, 17, 47, 48, 49, 100, 1024};
+    for (usize size = 0; size <= 400; ++size) {
+        u64 expected = hash_bytes_seed(data, size, 42);
+
+        for (usize s = 0; s < countof(steps); ++s) {
+            Hash_State state;
+            hash_begin(&state, 42);
+
+            for (usize i = 0; i < size; i += steps[s]) {
+                hash_update(&state, data + i, size - i < steps[s] ? size - i : steps[s]);
+            }
+
+            assert(hash_end(&state) == expected);
+        }
+    }
+
+    assert(hash_bytes(data, 100) != hash_bytes_seed(data, 100, 1));
+    assert(hash_bytes(data, 100) != hash_bytes(data + 1, 100));
+    puts("streaming matches one-shot");
+
+    // The bulk version must match the scalar one, including the leftover keys
+    u64 keys[1003], bulk[1003];
+    for (usize i = 0; i < countof(keys); ++i) {
+        keys[i] = rng();
+    }
+
+    hash_u64_bulk(keys, bulk, countof(keys), 7);
+    for (usize i = 0; i < countof(keys); ++i) {
+        assert(bulk[i] == hash_u64_seed(keys[i], 7));
+    }
+
+    // Byte strings of every length up to a few blocks, all out of 'data'
+    const void *strings[countof(keys)];
+    usize sizes[countof(keys)];
+    for (usize i = 0; i < countof(keys); ++i) {
+        strings[i] = data + i % 64;
+        sizes[i] = i % 150;
+    }
+
+    hash_bytes_bulk(strings, sizes, bulk, countof(keys), 7);
+    for (usize i = 0; i < countof(keys); ++i) {
+        assert(bulk[i] == hash_bytes_seed(strings[i], sizes[i], 7));
+    }
+
+    puts("bulk matches scalar");
+
+    f64 bias;
+    bias = avalanche(hash_bytes_seed, 8, 20000);  printf("avalanche bytes/8:     %.4f\n", bias); assert(bias < 0.03);
+    bias = avalanche(hash_bytes_seed, 24, 10000); printf("avalanche bytes/24:    %.4f\n", bias); assert(bias < 0.03);
+    bias = avalanche(hash_bytes_seed, 64, 10000); printf("avalanche bytes/64:    %.4f\n", bias); assert(bias < 0.03);
+    bias = avalanche(hash_u64_key, 8, 20000);     printf("avalanche u64:         %.4f\n", bias); assert(bias < 0.03);
+
+    for (usize i = 0; i < NUM_KEYS; ++i) {
+        u64 key = i;
+        hashes[i] = hash_bytes(&key, sizeof(key));
+    }
+    check_distribution("bytes sequential:", NUM_KEYS);
+
+    for (usize i = 0; i < NUM_KEYS; ++i) {
+        hashes[i] = hash_u64(i);
+    }
+    check_distribution("u64 sequential:", NUM_KEYS);
+
+    // Keys spaced by powers of two, where weak mixers tend to fall apart
+    for (usize i = 0; i < NUM_KEYS; ++i) {
+        hashes[i] = hash_u64((u64)i << 20);
+    }
+    check_distribution("u64 spaced:", NUM_KEYS);
+
+    // Every 256-bit key with at most two bits set
+    usize count = 0;
+    ubyte key[32];
+    for (u32 a = 0; a < 256; ++a) {
+        for (u32 b = a; b < 256; ++b) {
+            memset(key, 0, sizeof(key));
+            key[a / 8] |= (ubyte)(1 << (a % 8));
+            key[b / 8] |= (ubyte)(1 << (b % 8));
+            hashes[count++] = hash_bytes(key, sizeof(key));
+        }
+    }
+
+    usize collisions;
+    f64 low, high;
+    distribution("bytes sparse:", count, &collisions, &low, &high);
+    assert(collisions == 0);
+
+    // Text-like keys that only differ in a few characters
+    char text[32];
+    for (usize i = 0; i < NUM_KEYS; ++i) {
+        int n = snprintf(text, sizeof(text), "identifier_%zu", i);
+        hashes[i] = hash_bytes(text, (usize)n);
+    }
+    check_distribution("bytes text:", NUM_KEYS);
+
+    puts("");
+
+    return 0;
+}
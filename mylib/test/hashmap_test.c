@@ -0,0 +1,105 @@
+#include "../src/hashmap.h"
+
+#include <stdio.h>
+
+typedef struct _Route {
+    u32 src, dst;
+} Route;
+
+typedef struct _Route_Entry {
+    Route key;
+    u32   hops;
+    f32   cost;
+} Route_Entry;
+
+#define N 100000
+
+int main(void) {
+    puts("-- hashmap test --");
+
+    struct { u64 key; u64 value; } *m = NULL;
+
+    for (u64 i = 0; i < N; ++i) {
+        hashmap_put(m, i * 7919, i);
+    }
+
+    assert(hashmap_count(m) == N);
+
+    for (u64 i = 0; i < N; ++i) {
+        assert(hashmap_get(m, i * 7919) != NULL);
+        assert(hashmap_get(m, i * 7919)->value == i);
+        assert(!hashmap_has(m, i * 7919 + 1));
+    }
+
+    // Overwriting keeps the count
+    hashmap_put(m, 0, 42);
+    assert(hashmap_count(m) == N && hashmap_get(m, 0)->value == 42);
+
+    printf("put/get: %zu entries, capacity %zu, %zu slots\n", hashmap_count(m), hashmap_capacity(m), _hashmap_header(m)->num_slots);
+
+    for (u64 i = 0; i < N; i += 2) {
+        bool removed = hashmap_remove(m, i * 7919);
+        assert(removed);
+    }
+
+    bool removed = hashmap_remove(m, 0);
+    assert(!removed);
+    assert(hashmap_count(m) == N / 2);
+
+    for (u64 i = 0; i < N; ++i) {
+        assert(hashmap_has(m, i * 7919) == (i % 2 == 1));
+    }
+
+    // Entries stay packed, so iterating them touches only live ones
+    u64 sum = 0;
+    for (usize i = 0; i < hashmap_count(m); ++i) {
+        sum += m[i].value;
+        assert(m[i].key % 7919 == 0 && m[i].key / 7919 == m[i].value);
+    }
+
+    assert(sum == (u64)N / 2 * (N / 2));
+
+    printf("remove: %zu left, %zu tombstones\n", hashmap_count(m), _hashmap_header(m)->num_deleted);
+
+    // Churn at a steady size must rebuild the index in place instead of growing it
+    usize num_slots = _hashmap_header(m)->num_slots;
+    for (u64 i = 0; i < 10 * N; ++i) {
+        hashmap_put(m, (N + i) * 7919, i);
+        removed = hashmap_remove(m, (N + i) * 7919);
+        assert(removed);
+    }
+
+    assert(hashmap_count(m) == N / 2 && _hashmap_header(m)->num_slots == num_slots);
+    printf("churn: %zu slots, %zu tombstones\n", _hashmap_header(m)->num_slots, _hashmap_header(m)->num_deleted);
+
+    hashmap_clear(m);
+    assert(hashmap_count(m) == 0 && !hashmap_has(m, 7919));
+
+    hashmap_free(m);
+    assert(m == NULL);
+
+    // Struct keys on an arena
+    ubyte buffer[KB(16)];
+    Arena arena;
+    arena_init(&arena, buffer, sizeof(buffer));
+
+    Route_Entry *routes = NULL;
+    hashmap_init(routes, arena_allocator(&arena), 8);
+
+    for (u32 i = 0; i < 64; ++i) {
+        Route_Entry e = {{i, i * i}, i % 5, (f32)i * 0.5f};
+        hashmap_put_entry(routes, e);
+    }
+
+    Route r = {7, 49};
+    Route_Entry *found = hashmap_get(routes, r);
+    assert(found != NULL && found->hops == 2 && found->cost == 3.5f);
+
+    r.dst = 48;
+    assert(hashmap_get(routes, r) == NULL);
+    assert(hashmap_index(routes, r) == -1);
+
+    printf("arena: %zu routes, %zu bytes of arena used\n\n", hashmap_count(routes), arena.cur_offset);
+
+    return 0;
+}
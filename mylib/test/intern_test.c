@@ -0,0 +1,115 @@
+#include "../src/core.h"
+#include "../src/intern.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+#define NUM_THREADS  8
+#define NUM_NAMES    20000
+
+global Interner interner;
+global u32 thread_ids[NUM_THREADS][NUM_NAMES];
+
+internal String name(u32 i, char *buffer) {
+    return string_make(buffer, (usize)sprintf(buffer, "identifier_%u", i));
+}
+
+// Every thread interns the same names in a different order while the others do the same
+void *worker(void *arg) {
+    usize t = (usize)arg;
+    char buffer[32];
+
+    for (u32 n = 0; n < NUM_NAMES; ++n) {
+        u32 i = (u32)((n * 7919u + t * 104729u) % NUM_NAMES);
+        thread_ids[t][i] = interner_put(&interner, name(i, buffer));
+
+        // Whatever another thread interned must be visible in full right away
+        u32 other = (u32)((n * 31u) % NUM_NAMES);
+        u32 id = interner_find(&interner, name(other, buffer));
+        if (id != INTERNER_INVALID_ID && !string_equal(interner_get(&interner, id), name(other, buffer))) {
+            fprintf(stderr, "thread %zu found a wrong string for %u\n", t, other);
+            exit(1);
+        }
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    puts("-- intern test --");
+
+    Arena arena;
+    arena_init_virtual(&arena, GB(1));
+    interner_init(&interner, &arena);
+
+    u32 a = interner_put(&interner, string_lit("position"));
+    u32 b = interner_put_cstr(&interner, "normal");
+    char buffer[32] = "position";
+    u32 c = interner_put(&interner, string_make(buffer, 8));
+
+    assert(a == 0 && b == 1 && c == a);
+    assert(interner_count(&interner) == 2);
+    // The canonical copy is NUL-terminated and doesn't alias the input
+    assert(interner_get(&interner, a).data != buffer);
+    assert(strcmp(interner_get(&interner, a).data, "position") == 0);
+    assert(interner_find(&interner, string_lit("color")) == INTERNER_INVALID_ID);
+    assert(interner_find(&interner, string_lit("")) == INTERNER_INVALID_ID);
+    u32 empty = interner_put(&interner, string_lit(""));
+    assert(empty == 2);
+    assert(interner_find(&interner, string_lit("")) == 2);
+
+    // Many IDs across several chunks and index resizes, with pointers that never move
+    const char *first = interner_get(&interner, a).data;
+    for (u32 i = 0; i < 100000; ++i) {
+        u32 id = interner_put(&interner, name(i, buffer));
+        assert(id == 3 + i);
+    }
+    for (u32 i = 0; i < 100000; ++i) {
+        assert(interner_find(&interner, name(i, buffer)) == 3 + i);
+        assert(string_equal(interner_get(&interner, 3 + i), name(i, buffer)));
+    }
+    assert(interner_get(&interner, a).data == first);
+    puts("put and find");
+
+    // A whole file's worth of tokens at once
+    const char *text = "vertex\nfragment\nvertex\n\ncompute\nfragment\n";
+    u32 *ids = interner_put_split(&interner, string_from_cstr(text), '\n', heap_allocator());
+
+    assert(array_count(ids) == 6);
+    assert(ids[0] == ids[2] && ids[1] == ids[5]);
+    assert(ids[3] == 2);
+    assert(string_equal(interner_get(&interner, ids[4]), string_lit("compute")));
+    array_free(ids);
+    puts("bulk");
+
+    interner_release(&interner);
+    arena_release(&arena);
+
+    arena_init_virtual(&arena, GB(1));
+    interner_init(&interner, &arena);
+
+    pthread_t threads[NUM_THREADS];
+    for (usize t = 0; t < NUM_THREADS; ++t) {
+        pthread_create(&threads[t], NULL, worker, (void *)t);
+    }
+    for (usize t = 0; t < NUM_THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+
+    // All threads agree on every ID and each name got exactly one
+    assert(interner_count(&interner) == NUM_NAMES);
+    for (u32 i = 0; i < NUM_NAMES; ++i) {
+        for (usize t = 1; t < NUM_THREADS; ++t) {
+            assert(thread_ids[t][i] == thread_ids[0][i]);
+        }
+        assert(string_equal(interner_get(&interner, thread_ids[0][i]), name(i, buffer)));
+    }
+    puts("concurrent put and find");
+
+    interner_release(&interner);
+    arena_release(&arena);
+
+    puts("");
+
+    return 0;
+}
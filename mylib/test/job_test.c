@@ -0,0 +1,133 @@
+#include "../src/core.h"
+#include "../src/job.h"
+
+#include <stdio.h>
+
+#define NUM_WORKERS  4
+#define NUM_JOBS     10000
+#define COUNT        (1 << 20)
+
+global Job_System jobs;
+
+global u32 ran;
+global ubyte visits[COUNT];
+
+void count_job(void *data, Arena *scratch) {
+    // Scratch memory is only good until the job returns
+    u32 *tmp = (u32 *)arena_alloc(scratch, 64 * sizeof(u32));
+    assert(tmp != NULL);
+    tmp[63] = (u32)(usize)data;
+
+    __atomic_add_fetch(&ran, tmp[63], __ATOMIC_RELAXED);
+}
+
+void visit_range(void *data, usize begin, usize end, Arena *scratch) {
+    assert(begin < end && end <= COUNT);
+    void *tmp = arena_alloc(scratch, 1024);
+    assert(tmp != NULL);
+
+    for (usize i = begin; i < end; ++i) {
+        ++visits[i];
+    }
+
+    __atomic_add_fetch((u64 *)data, end - begin, __ATOMIC_RELAXED);
+}
+
+typedef struct _Nested {
+    u64 *sums;
+    u32  rows;
+} Nested;
+
+// Every row sums its columns with a parallel_for of its own, waiting inside a job
+void sum_columns(void *data, usize begin, usize end, Arena *scratch) {
+    u64 *sum = (u64 *)data;
+
+    for (usize i = begin; i < end; ++i) {
+        *sum += i;
+    }
+
+    void *tmp = arena_alloc(scratch, 256);
+    assert(tmp != NULL);
+}
+
+void sum_rows(void *data, usize begin, usize end, Arena *scratch) {
+    Nested *nested = (Nested *)data;
+
+    for (usize row = begin; row < end; ++row) {
+        u64 *row_sum = (u64 *)arena_alloc(scratch, sizeof(u64));
+        *row_sum = 0;
+
+        // The pieces all add into one sum, so they must not run in parallel
+        job_parallel_for(&jobs, 1000 * (row + 1), 1000 * (row + 1), sum_columns, row_sum);
+
+        nested->sums[row] = *row_sum;
+    }
+}
+
+int main(void) {
+    puts("-- job test --");
+
+    Arena arena;
+    arena_init_virtual(&arena, GB(1));
+    bool ok = job_system_init(&jobs, NUM_WORKERS, &arena);
+    assert(ok);
+    assert(jobs.num_workers == NUM_WORKERS && job_worker == &jobs.workers[0]);
+
+    Job_Counter counter = {0};
+    u64 expected = 0;
+
+    for (usize i = 0; i < NUM_JOBS; ++i) {
+        job_run(&jobs, count_job, (void *)(i % 7), &counter);
+        expected += i % 7;
+    }
+
+    job_wait(&jobs, &counter);
+    assert(counter.pending == 0 && ran == expected);
+    puts("run and wait");
+
+    u64 total = 0;
+    job_parallel_for(&jobs, COUNT, 0, visit_range, &total);
+    assert(total == COUNT);
+    for (usize i = 0; i < COUNT; ++i) {
+        assert(visits[i] == 1);
+    }
+
+    // Ranges that don't split evenly, and tiny grains that overflow the deque and run inline
+    total = 0;
+    job_parallel_for(&jobs, 12345, 1, visit_range, &total);
+    assert(total == 12345);
+    total = 0;
+    job_parallel_for(&jobs, 0, 0, visit_range, &total);
+    assert(total == 0);
+
+    u32 *values = NULL;
+    array_init(values, arena_allocator(&arena), 1000);
+    array_resize(values, 1000);
+    total = 0;
+    job_parallel_for_array(&jobs, values, 100, visit_range, &total);
+    assert(total == 1000);
+    puts("parallel for");
+
+    u64 sums[32];
+    Nested nested = {sums, 32};
+    job_parallel_for(&jobs, nested.rows, 1, sum_rows, &nested);
+
+    for (u64 row = 0; row < nested.rows; ++row) {
+        u64 n = 1000 * (row + 1);
+        assert(sums[row] == n * (n - 1) / 2);
+    }
+
+    // Every job's scratch allocations were given back
+    for (u32 i = 0; i < NUM_WORKERS; ++i) {
+        assert(jobs.workers[i].scratch.cur_offset == 0);
+    }
+    puts("nested jobs and scratch");
+
+    job_system_release(&jobs);
+    assert(job_worker == NULL);
+    arena_release(&arena);
+
+    puts("");
+
+    return 0;
+}
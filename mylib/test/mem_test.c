@@ -1,7 +1,33 @@
+#define MEM_STATS
 #include "../src/core.h"
 
 #include <stdio.h>
 
+char *join_words(Arena *mem, const char **words, int count) {
+    // 'mem' may itself be a scratch arena of the caller, so it must not be reused for temporaries
+    Tmp_Arena scratch = scratch_begin(&mem, 1);
+
+    usize *lens = (usize *)arena_alloc(scratch.mem, count * sizeof(usize));
+    usize total = 0;
+    for (int i = 0; i < count; ++i) {
+        lens[i] = strlen(words[i]);
+        total += lens[i] + 1;
+    }
+
+    char *ret = (char *)arena_alloc(mem, total);
+    char *at = ret;
+    for (int i = 0; i < count; ++i) {
+        memcpy(at, words[i], lens[i]);
+        at += lens[i];
+        *at++ = ' ';
+    }
+    ret[total - 1] = '\0';
+
+    scratch_end(scratch);
+
+    return ret;
+}
+
 int main(void) {
     ubyte buffer[KB(1)];
     Arena a;
@@ -33,6 +59,151 @@ int main(void) {
         printf("%p: %s\n", str, str);
     }
 
+    puts("-- virtual arena test --");
+    Arena va;
+    bool ok = arena_init_virtual(&va, GB(4));
+    assert(ok);
+
+    for (int i = 0; i < 3; ++i) {
+        Tmp_Arena tmp = tmp_arena_begin(&va);
+
+        // Grow well past the decommit threshold, then give it back
+        ubyte *big = (ubyte *)arena_alloc(&va, MB(100));
+        assert(big != NULL);
+        memset(big, 0xab, MB(100));
+
+        printf("committed after alloc: %zu bytes\n", va.total_size);
+
+        tmp_arena_end(tmp);
+
+        printf("committed after tmp end: %zu bytes\n", va.total_size);
+    }
+
+    str = (char *)arena_alloc(&va, 16);
+    memmove(str, "Hellope", 8);
+    str = (char *)arena_resize(&va, str, 16, MB(1));
+    printf("%p: %s\n", str, str);
+
+    arena_release(&va);
+
+    puts("-- chained arena test --");
+    Arena ca;
+    arena_init_chained(&ca, buffer, 128, KB(4));
+
+    for (int i = 0; i < 3; ++i) {
+        Tmp_Arena tmp = tmp_arena_begin(&ca);
+
+        // Spills out of 'buffer' into blocks, which are recycled on every iteration
+        for (int j = 0; j < 100; ++j) {
+            int *n = (int *)arena_alloc(&ca, 100 * sizeof(int));
+            assert(n != NULL);
+            n[99] = j;
+        }
+
+        printf("block after allocs: %p\n", (void *)ca.block);
+
+        tmp_arena_end(tmp);
+
+        printf("block after tmp end: %p (offset %zu)\n", (void *)ca.block, ca.cur_offset);
+    }
+
+    str = (char *)arena_alloc(&ca, 16);
+    memmove(str, "Hellope", 8);
+    str = (char *)arena_resize(&ca, str, 16, KB(8));
+    printf("%p: %s\n", str, str);
+
+    arena_release(&ca);
+
+    // Blocks come from the parent allocator, here another arena
+    Arena parent;
+    arena_init_virtual(&parent, MB(1));
+    arena_init_chained_allocator(&ca, NULL, 0, KB(4), arena_allocator(&parent));
+
+    str = (char *)arena_alloc(&ca, KB(6));
+    assert(str != NULL && ca.block != NULL && parent.cur_offset >= KB(6));
+    assert(parent.data < (ubyte *)str && (ubyte *)str < parent.data + parent.cur_offset);
+
+    arena_release(&ca);
+    arena_release(&parent);
+
+    puts("-- scratch arena test --");
+    {
+        Tmp_Arena scratch = scratch_begin(NULL, 0);
+
+        const char *words[] = {"Hellope", "scratch", "world!"};
+        char *joined = join_words(scratch.mem, words, countof(words));
+        printf("%p: %s\n", joined, joined);
+
+        scratch_end(scratch);
+        scratch_release();
+    }
+
+    puts("-- slab test --");
+    {
+        Slab slab;
+        ok = slab_init(&slab, GB(1));
+        assert(ok);
+
+        usize sizes[] = {1, 16, 17, 100, 129, 200, 1000, 4097, 8192, 10000};
+        void *ptrs[countof(sizes)];
+
+        for (usize i = 0; i < countof(sizes); ++i) {
+            ptrs[i] = slab_alloc(&slab, sizes[i]);
+            memset(ptrs[i], 0xcd, sizes[i]);
+        }
+
+        for (usize i = 0; i < countof(sizes) - 1; ++i) {
+            printf("%5zu bytes -> %5zu byte chunk at %p\n", sizes[i], slab_size(&slab, ptrs[i]), ptrs[i]);
+        }
+
+        for (usize i = 0; i < countof(sizes); ++i) {
+            slab_free(&slab, ptrs[i]);
+        }
+
+        // Freed chunks are handed out again
+        void *again = slab_alloc(&slab, 100);
+        printf("realloc of 100 bytes reuses chunk: %s\n", again == ptrs[3] ? "yes" : "no");
+
+        slab_release(&slab);
+    }
+
+    puts("-- buddy test --");
+    {
+        Buddy b;
+        buddy_init(&b, buffer, sizeof(buffer));
+
+        void *p0 = buddy_alloc(&b, 100);
+        void *p1 = buddy_alloc(&b, 20);
+        void *p2 = buddy_alloc(&b, 200);
+        printf("p0 = %p, p1 = %p, p2 = %p\n", p0, p1, p2);
+
+        Buddy_Stats st = buddy_stats(&b);
+        printf("used: %zu requested: %zu free: %zu largest free: %zu fragmentation: %.2f\n",
+               st.used_size, st.requested_size, st.free_size, st.largest_free_size, st.external_fragmentation);
+
+        buddy_free(&b, p1);
+        p0 = buddy_resize(&b, p0, 110);
+        memmove(p0, "Hellope", 8);
+        p0 = buddy_resize(&b, p0, 400);
+        printf("%p: %s\n", p0, (char *)p0);
+
+        // Larger than the largest order, down to sizes that used to wrap around with the header
+        void *too_big = buddy_alloc(&b, (usize)1 << 60);
+        assert(too_big == NULL);
+        too_big = buddy_alloc(&b, (usize)-1);
+        assert(too_big == NULL);
+        too_big = buddy_resize(&b, p2, (usize)-8);
+        assert(too_big == NULL);
+
+        buddy_free(&b, p0);
+        buddy_free(&b, p2);
+
+        // Everything coalesces back into a single block
+        st = buddy_stats(&b);
+        printf("free blocks after freeing everything: %zu (%zu bytes)\n", st.num_free_blocks, st.free_size);
+        assert(st.num_free_blocks == 1 && st.free_size == st.total_size);
+    }
+
     puts("-- pool test --");
     Pool p;
     pool_init(&p, buffer, KB(1), 64);
@@ -114,5 +285,23 @@ int main(void) {
     pool_free(&p, v0);
     pool_free(&p, v3);
 
+    // Running out of chunks, and a pool whose pages couldn't be mapped, both hand out NULL
+    Pool small;
+    pool_init(&small, buffer, 2 * 64, 64);
+    void *c0 = pool_alloc(&small);
+    void *c1 = pool_alloc(&small);
+    void *c2 = pool_alloc(&small);
+    assert(c0 != NULL && c1 != NULL && c2 == NULL);
+
+    Pool failed;
+    Page_Mem failed_mem = pool_init_huge(&failed, (usize)1 << 62, 64, NUMA_NODE_ANY);
+    void *from_failed = pool_alloc(&failed);
+    assert(failed_mem.data == NULL && from_failed == NULL);
+    page_mem_free(failed_mem);
+
+    puts("-- memory stats --");
+    arena_print_stats(stdout, &a, "a");
+    pool_print_stats(stdout, &p, "p");
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "../src/core.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+#define NUM_THREADS  8
+#define NUM_CHUNKS   256
+#define NUM_ROUNDS   20000
+#define CHUNK_SIZE   64
+
+global Atomic_Pool pool;
+global ubyte buffer[NUM_CHUNKS * CHUNK_SIZE + POOL_DEFAULT_ALIGNMENT];
+
+global bool use_magazines;
+
+void *worker(void *arg) {
+    usize id = (usize)arg;
+    Pool_Magazine mag;
+    pool_magazine_init(&mag, &pool);
+
+    usize *held[NUM_CHUNKS / NUM_THREADS];
+
+    for (usize round = 0; round < NUM_ROUNDS; ++round) {
+        usize count = 1 + (round + id) % countof(held);
+        usize got = 0;
+
+        for (usize i = 0; i < count; ++i) {
+            usize *chunk = (usize *)(use_magazines ? pool_magazine_alloc(&mag) : atomic_pool_alloc(&pool));
+            if (chunk == NULL) {
+                break;
+            }
+
+            // Stamp the whole chunk so that handing it out twice gets caught below
+            for (usize j = 0; j < CHUNK_SIZE / sizeof(usize); ++j) {
+                chunk[j] = id;
+            }
+
+            held[got++] = chunk;
+        }
+
+        for (usize i = 0; i < got; ++i) {
+            for (usize j = 0; j < CHUNK_SIZE / sizeof(usize); ++j) {
+                if (held[i][j] != id) {
+                    fprintf(stderr, "chunk %p shared between threads %zu and %zu\n", (void *)held[i], id, held[i][j]);
+                    exit(1);
+                }
+            }
+
+            if (use_magazines) {
+                pool_magazine_free(&mag, held[i]);
+            } else {
+                atomic_pool_free(&pool, held[i]);
+            }
+        }
+    }
+
+    pool_magazine_flush(&mag);
+
+    return NULL;
+}
+
+internal usize stress(void) {
+    atomic_pool_init(&pool, buffer, sizeof(buffer), CHUNK_SIZE);
+
+    pthread_t threads[NUM_THREADS];
+    for (usize i = 0; i < NUM_THREADS; ++i) {
+        pthread_create(&threads[i], NULL, worker, (void *)i);
+    }
+
+    for (usize i = 0; i < NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Every chunk must have made it back onto the free list exactly once
+    usize free_chunks = 0;
+    void *batch[16];
+    usize n = 0;
+    while ((n = atomic_pool_alloc_batch(&pool, batch, countof(batch))) > 0) {
+        free_chunks += n;
+    }
+
+    printf("free chunks after %d threads x %d rounds: %zu (expected %d)\n",
+           NUM_THREADS, NUM_ROUNDS, free_chunks, NUM_CHUNKS);
+
+    return free_chunks;
+}
+
+int main(void) {
+    puts("-- atomic pool stress test --");
+    usize shared = stress();
+
+    puts("-- pool magazine stress test --");
+    use_magazines = true;
+    usize cached = stress();
+
+    return (shared == NUM_CHUNKS && cached == NUM_CHUNKS) ? 0 : 1;
+}
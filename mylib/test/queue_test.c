@@ -0,0 +1,224 @@
+#include "../src/core.h"
+#include "../src/queue.h"
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define NUM_ITEMS      (1 << 20)
+#define NUM_PRODUCERS  4
+#define NUM_CONSUMERS  4
+#define BATCH_SIZE     16
+
+global Spsc_Queue spsc;
+global Mpmc_Queue mpmc;
+
+global Atomic_Pool message_pool;
+
+typedef struct _Message {
+    u32 producer;
+    u32 seq;
+    u64 payload[6];
+} Message;
+
+// Sends 0..NUM_ITEMS-1 in batches of varying size
+void *spsc_producer(void *arg) {
+    u64 batch[BATCH_SIZE];
+    u64 next = 0;
+
+    while (next < NUM_ITEMS) {
+        usize n = 1 + next % BATCH_SIZE;
+        for (usize i = 0; i < n; ++i) {
+            batch[i] = next + i;
+        }
+
+        n = n < NUM_ITEMS - next ? n : NUM_ITEMS - next;
+        usize sent = 0;
+
+        while (sent < n) {
+            usize pushed = spsc_queue_push_batch(&spsc, batch + sent, n - sent);
+            if (pushed == 0) {
+                sched_yield();
+            }
+            sent += pushed;
+        }
+
+        next += n;
+    }
+
+    return arg;
+}
+
+void *mpmc_producer(void *arg) {
+    u32 producer = (u32)(usize)arg;
+
+    for (u32 i = 0; i < NUM_ITEMS / NUM_PRODUCERS; ++i) {
+        Message *m;
+        while ((m = (Message *)atomic_pool_alloc(&message_pool)) == NULL) {
+            sched_yield();
+        }
+
+        m->producer = producer;
+        m->seq = i;
+        m->payload[5] = (u64)producer * NUM_ITEMS + i;
+
+        while (!mpmc_queue_push(&mpmc, &m)) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+global u64 consumer_sums[NUM_CONSUMERS];
+global u64 consumer_counts[NUM_CONSUMERS];
+global bool producers_done;
+
+void *mpmc_consumer(void *arg) {
+    usize consumer = (usize)arg;
+    // The last sequence number seen from each producer, which must keep increasing
+    i64 last_seq[NUM_PRODUCERS] = {-1, -1, -1, -1};
+    Message *batch[BATCH_SIZE];
+
+    for (;;) {
+        usize n = mpmc_queue_pop_batch(&mpmc, batch, 1 + consumer * 5);
+
+        if (n == 0) {
+            // Everything was pushed before the flag was set, so empty now means done
+            if (__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+
+            sched_yield();
+            continue;
+        }
+
+        for (usize i = 0; i < n; ++i) {
+            Message *m = batch[i];
+
+            if ((i64)m->seq <= last_seq[m->producer] || m->payload[5] != (u64)m->producer * NUM_ITEMS + m->seq) {
+                fprintf(stderr, "consumer %zu got a bad message %u/%u\n", consumer, m->producer, m->seq);
+                exit(1);
+            }
+
+            last_seq[m->producer] = m->seq;
+            consumer_sums[consumer] += m->seq;
+            ++consumer_counts[consumer];
+
+            atomic_pool_free(&message_pool, m);
+        }
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    puts("-- queue test --");
+
+    Arena arena;
+    arena_init_virtual(&arena, GB(1));
+
+    // Single-threaded edge cases first
+    Spsc_Queue q;
+    spsc_queue_init_arena(&q, &arena, 8, sizeof(u32));
+
+    u32 in[20], out[20];
+    for (u32 i = 0; i < countof(in); ++i) {
+        in[i] = i;
+    }
+
+    bool ok = spsc_queue_pop(&q, out);
+    assert(!ok);
+    usize num = spsc_queue_push_batch(&q, in, 5);
+    assert(num == 5);
+    num = spsc_queue_pop_batch(&q, out, 3);
+    assert(num == 3 && out[2] == 2);
+    // Wraps around the end of the ring
+    num = spsc_queue_push_batch(&q, in + 5, 20);
+    assert(num == 6);
+    assert(spsc_queue_count(&q) == 8);
+    ok = spsc_queue_push(&q, in);
+    assert(!ok);
+    num = spsc_queue_pop_batch(&q, out, 20);
+    assert(num == 8);
+    for (u32 i = 0; i < 8; ++i) {
+        assert(out[i] == 3 + i);
+    }
+
+    Mpmc_Queue mq;
+    mpmc_queue_init_arena(&mq, &arena, 8, 3);
+
+    char bytes[30] = "abcdefghijklmnopqrstuvwxyz";
+    char got[30];
+    num = mpmc_queue_pop_batch(&mq, got, 4);
+    assert(num == 0);
+    num = mpmc_queue_push_batch(&mq, bytes, 5);
+    assert(num == 5);
+    num = mpmc_queue_pop_batch(&mq, got, 2);
+    assert(num == 2 && memcmp(got, "abcdef", 6) == 0);
+    num = mpmc_queue_push_batch(&mq, bytes + 15, 10);
+    assert(num == 5);
+    ok = mpmc_queue_push(&mq, bytes);
+    assert(!ok);
+    num = mpmc_queue_pop_batch(&mq, got, 10);
+    assert(num == 8);
+    assert(memcmp(got, "ghijklmnopqrstuvwxyz", 21) == 0);
+    puts("single-threaded");
+
+    spsc_queue_init_arena(&spsc, &arena, 1024, sizeof(u64));
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, spsc_producer, NULL);
+
+    u64 expected = 0, batch[BATCH_SIZE * 2];
+    while (expected < NUM_ITEMS) {
+        usize n = spsc_queue_pop_batch(&spsc, batch, 1 + expected % countof(batch));
+        if (n == 0) {
+            sched_yield();
+        }
+
+        for (usize i = 0; i < n; ++i) {
+            assert(batch[i] == expected);
+            ++expected;
+        }
+    }
+
+    pthread_join(producer, NULL);
+    puts("spsc keeps order");
+
+    // Messages from a pool, passed by pointer
+    usize pool_size = 4096 * sizeof(Message);
+    atomic_pool_init(&message_pool, arena_alloc(&arena, pool_size), pool_size, sizeof(Message));
+    mpmc_queue_init_arena(&mpmc, &arena, 256, sizeof(Message *));
+
+    pthread_t producers[NUM_PRODUCERS], consumers[NUM_CONSUMERS];
+    for (usize i = 0; i < NUM_CONSUMERS; ++i) {
+        pthread_create(&consumers[i], NULL, mpmc_consumer, (void *)i);
+    }
+    for (usize i = 0; i < NUM_PRODUCERS; ++i) {
+        pthread_create(&producers[i], NULL, mpmc_producer, (void *)i);
+    }
+    for (usize i = 0; i < NUM_PRODUCERS; ++i) {
+        pthread_join(producers[i], NULL);
+    }
+
+    __atomic_store_n(&producers_done, true, __ATOMIC_RELEASE);
+
+    u64 sum = 0, count = 0;
+    for (usize i = 0; i < NUM_CONSUMERS; ++i) {
+        pthread_join(consumers[i], NULL);
+        sum += consumer_sums[i];
+        count += consumer_counts[i];
+    }
+
+    u64 per_producer = NUM_ITEMS / NUM_PRODUCERS;
+    assert(count == NUM_ITEMS);
+    assert(sum == NUM_PRODUCERS * (per_producer * (per_producer - 1) / 2));
+    puts("mpmc delivers everything once, in order per producer");
+
+    arena_release(&arena);
+
+    puts("");
+
+    return 0;
+}
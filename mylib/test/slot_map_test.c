@@ -0,0 +1,105 @@
+#include "../src/core.h"
+#include "../src/slot_map.h"
+
+#include <stdio.h>
+
+#define NUM_ENTITIES  10000
+
+typedef struct _Entity {
+    u32 id;
+    f32 position[3];
+} Entity;
+
+global Slot_Handle handles[NUM_ENTITIES];
+
+int main(void) {
+    puts("-- slot map test --");
+
+    usize size = slot_map_buffer_size(NUM_ENTITIES, sizeof(Entity));
+    void *mem = malloc(size);
+
+    Slot_Map map;
+    slot_map_init(&map, mem, size, sizeof(Entity));
+    assert(map.capacity == NUM_ENTITIES);
+
+    Slot_Handle none = {0, 0};
+    assert(slot_map_get(&map, none) == NULL);
+
+    for (u32 i = 0; i < NUM_ENTITIES; ++i) {
+        Entity *e = (Entity *)slot_map_alloc(&map, &handles[i]);
+        assert(e != NULL);
+        e->id = i;
+    }
+
+    Slot_Handle extra;
+    void *full = slot_map_alloc(&map, &extra);
+    assert(full == NULL);
+    assert(map.count == NUM_ENTITIES);
+    puts("alloc until full");
+
+    // Remove every third entity, the rest must still resolve to the right value
+    for (u32 i = 0; i < NUM_ENTITIES; i += 3) {
+        bool removed = slot_map_remove(&map, handles[i]);
+        assert(removed);
+        removed = slot_map_remove(&map, handles[i]);
+        assert(!removed);
+    }
+
+    for (u32 i = 0; i < NUM_ENTITIES; ++i) {
+        Entity *e = (Entity *)slot_map_get(&map, handles[i]);
+
+        if (i % 3 == 0) {
+            assert(e == NULL);
+        } else {
+            assert(e != NULL && e->id == i);
+        }
+    }
+
+    // The survivors are packed at the front, and each one's handle leads back to it
+    Entity *all = (Entity *)map.data;
+    u64 sum = 0;
+
+    for (u32 i = 0; i < map.count; ++i) {
+        sum += all[i].id;
+        assert(slot_map_index(&map, slot_map_handle(&map, i)) == (isize)i);
+        assert(slot_map_handle(&map, i).index == handles[all[i].id].index);
+    }
+
+    u64 expected = 0;
+    for (u32 i = 0; i < NUM_ENTITIES; ++i) {
+        expected += i % 3 ? i : 0;
+    }
+    assert(sum == expected && map.count == NUM_ENTITIES - (NUM_ENTITIES + 2) / 3);
+    puts("remove keeps values packed");
+
+    // Recycled slots come with a new generation, so the old handles stay invalid
+    for (u32 i = 0; i < NUM_ENTITIES; i += 3) {
+        Entity e = {NUM_ENTITIES + i, {0.0f, 0.0f, 0.0f}};
+        Slot_Handle h = slot_map_insert(&map, &e);
+
+        assert(h.generation == 2);
+        assert(slot_map_get(&map, handles[i]) == NULL);
+        assert(((Entity *)slot_map_get(&map, h))->id == NUM_ENTITIES + i);
+
+        handles[i] = h;
+    }
+    assert(map.count == NUM_ENTITIES);
+    puts("stale handles");
+
+    slot_map_clear(&map);
+    assert(map.count == 0);
+    for (u32 i = 0; i < NUM_ENTITIES; ++i) {
+        assert(!slot_map_has(&map, handles[i]));
+    }
+
+    Entity e = {7, {1.0f, 2.0f, 3.0f}};
+    Slot_Handle h = slot_map_insert(&map, &e);
+    assert(slot_map_has(&map, h) && map.count == 1);
+    puts("clear");
+
+    free(mem);
+
+    puts("");
+
+    return 0;
+}
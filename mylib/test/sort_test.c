@@ -0,0 +1,168 @@
+#include "../src/sort.h"
+
+#include <stdio.h>
+
+#define int_less(a, b) ((a) < (b))
+SORT_DEFINE(int, int, int_less)
+PARALLEL_SORT_DEFINE(int, int, int_less)
+
+typedef struct _Entry {
+    u32         id;
+    const char *name;
+} Entry;
+
+#define entry_less(a, b) ((a).id < (b).id)
+SORT_DEFINE(entry, Entry, entry_less)
+
+#define entry_key(x) ((x).id)
+RADIX_SORT_DEFINE(entry, Entry, u32, entry_key)
+
+#define N 100000
+
+typedef struct _Sort_In_Job {
+    Job_System *jobs;
+    int        *a;
+    usize       n;
+} Sort_In_Job;
+
+// Sorting from inside a job splits the work among the same workers instead of starting more threads
+void sort_in_job(void *data, Arena *scratch) {
+    Sort_In_Job *job = (Sort_In_Job *)data;
+
+    int_parallel_sort(job->a, job->n, scratch, job->jobs);
+}
+
+global int ints[N];
+global f32 floats[N];
+global i64 longs[N];
+
+int main(void) {
+    puts("-- sort test --");
+
+    u64 x = 88172645463325252ull;
+    for (usize i = 0; i < N; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        ints[i] = (int)(x % 1000) - 500;
+        floats[i] = (f32)(i64)(x % 200001 - 100000) * 0.25f;
+        longs[i] = (i64)x;
+    }
+
+    int_sort(ints, N);
+    f32_radix_sort(floats, N);
+    i64_radix_sort(longs, N);
+
+    for (usize i = 1; i < N; ++i) {
+        assert(ints[i - 1] <= ints[i]);
+        assert(floats[i - 1] <= floats[i]);
+        assert(longs[i - 1] <= longs[i]);
+    }
+
+    // The introsort radix sorts fall back to without scratch memory, ordering by the same keys
+    for (usize i = 0; i < N / 2; ++i) {
+        i64 swap = longs[i]; longs[i] = longs[N - 1 - i]; longs[N - 1 - i] = swap;
+    }
+
+    i64_radix_key_sort(longs, N);
+    for (usize i = 1; i < N; ++i) {
+        assert(longs[i - 1] <= longs[i]);
+    }
+
+    printf("ints:   %d .. %d\n", ints[0], ints[N - 1]);
+    printf("floats: %f .. %f\n", floats[0], floats[N - 1]);
+    printf("longs:  %lld .. %lld\n", (long long)longs[0], (long long)longs[N - 1]);
+
+    Entry entries[] = {{3, "c"}, {1, "a"}, {4, "d"}, {1, "a'"}, {2, "b"}};
+
+    entry_radix_sort(entries, countof(entries));
+    printf("entries (radix, stable):");
+    for (usize i = 0; i < countof(entries); ++i) {
+        printf(" %u:%s", entries[i].id, entries[i].name);
+    }
+    printf("\n");
+
+    int *arr = NULL;
+    array_push(arr, 3);
+    array_push(arr, 1);
+    array_push(arr, 2);
+    array_sort_with(arr, int);
+    printf("array: %d %d %d\n", arr[0], arr[1], arr[2]);
+    array_free(arr);
+
+    u32 *keys = NULL;
+    for (u32 i = 0; i < 100; ++i) {
+        array_push(keys, (i * 37) % 100);
+    }
+    array_sort_with(keys, u32_radix);
+    for (u32 i = 0; i < 100; ++i) {
+        assert(keys[i] == i);
+    }
+    array_sort_with(keys, u32_radix_key);
+    assert(keys[0] == 0 && keys[99] == 99);
+    array_free(keys);
+
+    // Odd worker count and size so that runs and output slices don't line up
+    usize big_n = 3 * PARALLEL_SORT_MIN_SIZE + 12345;
+    int *big = NULL;
+    array_resize(big, big_n);
+
+    u64 sum = 0, sorted_sum = 0;
+    for (usize i = 0; i < big_n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        big[i] = (int)(x % 100000);
+        sum += (u64)big[i];
+    }
+
+    Arena mem;
+    arena_init_virtual(&mem, GB(1));
+
+    Job_System jobs;
+    bool ok = job_system_init(&jobs, 3, &mem);
+    assert(ok);
+    int_parallel_sort(big, big_n, &mem, &jobs);
+
+    for (usize i = 0; i < big_n; ++i) {
+        assert(i == 0 || big[i - 1] <= big[i]);
+        sorted_sum += (u64)big[i];
+    }
+
+    assert(sum == sorted_sum);
+    printf("parallel: %zu ints, %d .. %d\n", big_n, big[0], big[big_n - 1]);
+
+    // Same again from inside a job, sorting a shuffled copy
+    for (usize i = big_n - 1; i > 0; --i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        usize j = x % (i + 1);
+        int swap = big[i]; big[i] = big[j]; big[j] = swap;
+    }
+
+    Job_Counter done = {0};
+    Sort_In_Job sort_job = {&jobs, big, big_n};
+    job_run(&jobs, sort_in_job, &sort_job, &done);
+    job_wait(&jobs, &done);
+    job_system_release(&jobs);
+
+    sorted_sum = 0;
+    for (usize i = 0; i < big_n; ++i) {
+        assert(i == 0 || big[i - 1] <= big[i]);
+        sorted_sum += (u64)big[i];
+    }
+
+    assert(sum == sorted_sum);
+    puts("sorted inside a job");
+
+    array_free(big);
+    arena_release(&mem);
+
+    scratch_release();
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "../src/core.h"
+#include "../src/stream.h"
+
+#include <stdio.h>
+
+#define TEST_PATH    "/tmp/mylib_stream_test.bin"
+#define SPARSE_PATH  "/tmp/mylib_stream_test_sparse.bin"
+
+internal ubyte pattern(u64 i) {
+    return (ubyte)(i * 31 % 251);
+}
+
+internal void write_test_file(const char *path, usize size) {
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+
+    for (usize i = 0; i < size; ++i) {
+        fputc(pattern(i), file);
+    }
+
+    fclose(file);
+}
+
+// Streams the whole file, checking that chunks are contiguous and hold the right bytes
+internal u64 stream_all(const char *path, usize chunk_size, bool read_ahead, Arena *arena, bool check) {
+    Tmp_Arena tmp = tmp_arena_begin(arena);
+
+    File_Stream stream;
+    bool ok = file_stream_open(&stream, path, chunk_size, read_ahead, arena);
+    assert(ok);
+
+    File_Chunk chunk;
+    u64 total = 0;
+    while (file_stream_next_chunk(&stream, &chunk)) {
+        assert(chunk.offset == total);
+        assert(chunk.count > 0 && chunk.count <= stream.chunk_size);
+
+        for (usize i = 0; check && i < chunk.count; ++i) {
+            assert((ubyte)chunk.data[i] == pattern(chunk.offset + i));
+        }
+
+        total += chunk.count;
+    }
+
+    assert(!stream.error);
+    // Reading past the end stays at the end
+    bool more = file_stream_next_chunk(&stream, &chunk);
+    assert(!more);
+
+    file_stream_close(&stream);
+    tmp_arena_end(tmp);
+
+    return total;
+}
+
+int main(void) {
+    puts("-- stream test --");
+
+    Arena arena;
+    arena_init_virtual(&arena, GB(1));
+
+    usize size = MB(10) + 777;
+    write_test_file(TEST_PATH, size);
+
+    usize chunk_sizes[] = {4096, MB(1), MB(3) + 1, MB(64), 0};
+    for (usize i = 0; i < countof(chunk_sizes); ++i) {
+        u64 got = stream_all(TEST_PATH, chunk_sizes[i], false, &arena, true);
+        assert(got == size);
+        got = stream_all(TEST_PATH, chunk_sizes[i], true, &arena, true);
+        assert(got == size);
+    }
+    puts("chunks cover the file in order");
+
+    // A file ending right on a chunk boundary, and an empty one
+    write_test_file(TEST_PATH, MB(2));
+    u64 got = stream_all(TEST_PATH, MB(1), true, &arena, true);
+    assert(got == MB(2));
+    got = stream_all(TEST_PATH, MB(1), false, &arena, true);
+    assert(got == MB(2));
+
+    write_test_file(TEST_PATH, 0);
+    got = stream_all(TEST_PATH, MB(1), true, &arena, true);
+    assert(got == 0);
+    got = stream_all(TEST_PATH, MB(1), false, &arena, true);
+    assert(got == 0);
+
+    // Closing early stops the reader while it waits for a buffer
+    write_test_file(TEST_PATH, MB(8));
+    File_Stream stream;
+    File_Chunk chunk;
+    bool ok = file_stream_open(&stream, TEST_PATH, MB(1), true, &arena);
+    assert(ok);
+    ok = file_stream_next_chunk(&stream, &chunk);
+    assert(ok && chunk.count == MB(1));
+    file_stream_close(&stream);
+
+    File_Stream missing;
+    ok = file_stream_open(&missing, "/tmp/mylib_stream_test_missing.bin", 0, true, &arena);
+    assert(!ok);
+    puts("edge cases");
+
+    // Sizes past what fits in an i32, without writing gigabytes to disk
+    u64 sparse_size = GB(3) + 17;
+    FILE *file = fopen(SPARSE_PATH, "wb");
+    assert(file != NULL);
+    int truncated = ftruncate(fileno(file), (off_t)sparse_size);
+    assert(truncated == 0);
+    fclose(file);
+
+    i64 sparse_file_size = file_size(SPARSE_PATH);
+    assert((u64)sparse_file_size == sparse_size);
+    got = stream_all(SPARSE_PATH, MB(16), true, &arena, false);
+    assert(got == sparse_size);
+    printf("streamed %llu bytes\n", (unsigned long long)sparse_size);
+
+    remove(TEST_PATH);
+    remove(SPARSE_PATH);
+    arena_release(&arena);
+
+    puts("");
+
+    return 0;
+}
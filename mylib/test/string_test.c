@@ -0,0 +1,199 @@
+#include "../src/core.h"
+#include "../src/str.h"
+
+#include <stdio.h>
+
+// Plain loops to check the SIMD paths against
+internal isize naive_find(String s, String needle) {
+    for (usize i = 0; i + needle.count <= s.count; ++i) {
+        if (memcmp(s.data + i, needle.data, needle.count) == 0) {
+            return (isize)i;
+        }
+    }
+
+    return -1;
+}
+
+internal isize naive_find_last_byte(String s, char c) {
+    for (usize i = s.count; i > 0; --i) {
+        if (s.data[i - 1] == c) {
+            return (isize)(i - 1);
+        }
+    }
+
+    return -1;
+}
+
+int main(void) {
+    puts("-- string test --");
+
+    local char text[256];
+
+    // Every length and every match position, so both the full chunks and the overlapping tail get hit
+    for (usize n = 0; n <= 70; ++n) {
+        for (usize pos = 0; pos <= n; ++pos) {
+            memset(text, 'a', n);
+            if (pos < n) {
+                text[pos] = 'x';
+            }
+
+            String s = string_make(text, n);
+            assert(string_find_byte(s, 'x') == (pos < n ? (isize)pos : -1));
+            assert(string_find_last_byte(s, 'x') == naive_find_last_byte(s, 'x'));
+            assert(string_find(s, string_lit("x")) == (pos < n ? (isize)pos : -1));
+        }
+    }
+
+    for (usize n = 0; n <= 80; ++n) {
+        for (usize i = 0; i < n; ++i) {
+            text[i] = "abcab"[(i * 7 + i / 3) % 5];
+        }
+
+        String s = string_make(text, n);
+        const char *needles[] = {"ab", "abc", "cab", "bcabc", "aaa", "abcabcab", "cabbacab", "z"};
+
+        for (usize k = 0; k < countof(needles); ++k) {
+            String needle = string_from_cstr(needles[k]);
+            assert(string_find(s, needle) == naive_find(s, needle));
+        }
+
+        for (usize k = 0; k < n; k += 3) {
+            String needle = string_slice(s, k, k + 19);
+            assert(string_find(s, needle) == naive_find(s, needle));
+        }
+    }
+
+    assert(string_find(string_lit("abc"), string_lit("")) == 0);
+    assert(string_find(string_lit("ab"), string_lit("abc")) == -1);
+    puts("find matches naive search");
+
+    // A difference at every position of every length
+    local char other[256];
+    for (usize n = 0; n <= 70; ++n) {
+        for (usize i = 0; i < n; ++i) {
+            text[i] = other[i] = (char)('a' + i % 26);
+        }
+
+        assert(string_equal(string_make(text, n), string_make(other, n)));
+        assert(string_compare(string_make(text, n), string_make(other, n)) == 0);
+
+        for (usize pos = 0; pos < n; ++pos) {
+            other[pos] = (char)0xF0;
+            assert(!string_equal(string_make(text, n), string_make(other, n)));
+            // Bytes compare as unsigned, like 'memcmp'
+            assert(string_compare(string_make(text, n), string_make(other, n)) < 0);
+            assert(string_compare(string_make(other, n), string_make(text, n)) > 0);
+            other[pos] = text[pos];
+        }
+    }
+
+    assert(string_compare(string_lit("abc"), string_lit("abcd")) < 0);
+    assert(string_compare(string_lit("b"), string_lit("abcd")) > 0);
+    assert(!string_equal(string_lit("abc"), string_lit("abcd")));
+    assert(string_starts_with(string_lit("config.ini"), string_lit("config")));
+    assert(string_ends_with(string_lit("config.ini"), string_lit(".ini")));
+    assert(!string_ends_with(string_lit("ini"), string_lit(".ini")));
+    puts("compare matches memcmp");
+
+    for (usize left = 0; left <= 40; ++left) {
+        for (usize right = 0; right <= 40; right += 3) {
+            usize n = 0;
+            for (usize i = 0; i < left; ++i) {
+                text[n++] = " \t\n\v\f\r"[i % 6];
+            }
+            memcpy(text + n, "key = value", 11);
+            n += 11;
+            for (usize i = 0; i < right; ++i) {
+                text[n++] = " \r\n"[i % 3];
+            }
+
+            assert(string_equal(string_trim(string_make(text, n)), string_lit("key = value")));
+            assert(string_trim_left(string_make(text, n)).count == n - left);
+            assert(string_trim_right(string_make(text, n)).count == left + 11);
+        }
+    }
+
+    memset(text, ' ', 40);
+    assert(string_trim(string_make(text, 40)).count == 0);
+    // Bytes above 127 are not whitespace
+    assert(string_trim(string_lit("\xA0x\x85")).count == 3);
+    puts("trim");
+
+    String rest = string_lit("a,,bc,"), token;
+    const char *expected[] = {"a", "", "bc"};
+    usize count = 0;
+
+    while (string_split_next(&rest, ',', &token)) {
+        assert(count < countof(expected));
+        assert(string_equal(token, string_from_cstr(expected[count])));
+        ++count;
+    }
+    assert(count == countof(expected));
+
+    local ubyte buffer[KB(64)];
+    Arena arena;
+    arena_init(&arena, buffer, sizeof(buffer));
+
+    String *lines = string_split(string_lit("first\nsecond\n\nfourth"), '\n', arena_allocator(&arena));
+    assert(array_count(lines) == 4);
+    assert(string_equal(lines[1], string_lit("second")));
+    assert(lines[2].count == 0);
+    String *none = string_split(string_lit(""), '\n', arena_allocator(&arena));
+    assert(none != NULL);
+    puts("split");
+
+    // As long as nothing else is allocated, the builder grows in place and never copies its text
+    arena_clear(&arena);
+
+    String_Builder sb;
+    string_builder_init(&sb, &arena);
+    string_builder_append(&sb, string_lit("[section]"));
+    const char *start = sb.data;
+
+    for (int i = 0; i < 500; ++i) {
+        string_builder_appendf(&sb, "\nkey_%d = %d", i, i * i);
+    }
+
+    assert(sb.data == start);
+    assert(sb.capacity > 4096);
+
+    String built = string_builder_end(&sb);
+    assert(strlen(built.data) == built.count);
+    assert(string_starts_with(built, string_lit("[section]\nkey_0 = 0\nkey_1 = 1\n")));
+    assert(string_ends_with(built, string_lit("key_499 = 249001")));
+    // The unused capacity was given back
+    assert(arena.cur_offset == built.count + 1);
+
+    // Something allocated in between makes it move once
+    string_builder_append_cstr(&sb, "abc");
+    void *in_between = arena_alloc(&arena, 16);
+    for (int i = 0; i < 100; ++i) {
+        string_builder_append_byte(&sb, (char)('0' + i % 10));
+    }
+
+    assert((char *)in_between < sb.data);
+    assert(sb.count == 103 && sb.data[103] == '\0');
+    assert(string_equal(string_slice(string_builder_to_string(&sb), 0, 5), string_lit("abc01")));
+
+    // Text longer than what is left of the arena fails without corrupting the builder
+    char *big = (char *)malloc(KB(128));
+    memset(big, 'x', KB(128) - 1);
+    big[KB(128) - 1] = '\0';
+
+    bool appended = string_builder_appendf(&sb, "%s", big);
+    assert(!appended);
+    assert(sb.count == 103 && strlen(sb.data) == 103);
+    free(big);
+
+    char *cstr = string_to_cstr(string_slice(built, 1, 8), &arena);
+    assert(strcmp(cstr, "section") == 0);
+    assert(string_hash(string_lit("key")) == hash_bytes("key", 3));
+    puts("builder");
+
+    log_trace("a message much longer than the 128 bytes the log used to format into, "
+              "which would have overflowed its buffer: %s", built.data + built.count - 200);
+
+    puts("");
+
+    return 0;
+}